@@ -11,22 +11,30 @@
 #define __CONVEXHULL_H__
 
 #include <vector>
+#include <random>
+#include <chrono>
+#include <fstream>
 #include <algorithm>
 
 #include "Point.h"
 #include "Tools.h"
 #include "PointList.h"
+#include "Profiler.h"
 
 using namespace std;
 
 /**
  * \brief comparator function used to compare x coordinates while sorting
+ * 
+ * Points with equal x coordinates are ordered by their y coordinate, which the 
+ * monotone chain in leafHull() relies on.
+ * 
  * \param a first Point object
  * \param b second Point object
  * \return true if a comes before b
  */
 bool xPointComparator(const Point &a, const Point &b) {
-    return (a.x < b.x);
+    return (a.x < b.x) || (a.x == b.x && a.y < b.y);
 }
 
 /**
@@ -34,6 +42,7 @@ bool xPointComparator(const Point &a, const Point &b) {
  * \param input PointList object containing the user input data points
  */
 void xAxisSort(PointList &input) {
+    PROFILE_SCOPE("sort");
     sort(input.begin(), input.end(), xPointComparator);
 }
 
@@ -54,12 +63,14 @@ pair<long long, long long> upperTangent(PointList& lHull, PointList& rHull) {
         while (orient(lHull[lp], rHull[rp], rHull[rq]) >= 0) {
             if (rq >= rHull.size()) break;
             check = true;
+            PROFILE_COUNT(TANGENT_STEPS);
             rp++;
             rq++;
         }
         while (orient(rHull[rp], lHull[lp], lHull[lq]) <= 0) {
             if (lq <= -1) break;
             check = true;
+            PROFILE_COUNT(TANGENT_STEPS);
             lp--;
             lq--;
         }
@@ -86,12 +97,14 @@ pair<long long, long long> lowerTangent(PointList& lHull, PointList& rHull) {
         while (orient(lHull[lp], rHull[rp], rHull[rq]) <= 0) {
             if (rq >= rHull.size()) break;
             check = true;
+            PROFILE_COUNT(TANGENT_STEPS);
             rp++;
             rq++;
         }
         while (orient(rHull[rp], lHull[lp], lHull[lq]) >= 0) {
             if (lq <= -1) break;
             check = true;
+            PROFILE_COUNT(TANGENT_STEPS);
             lp--;
             lq--;
         }
@@ -118,15 +131,79 @@ PointList combineHulls(PointList &uHull, PointList &lHull) {
     return output;
 }
 
+/**
+ * \brief Largest interval (in number of points) for which upperConvexHull() and lowerConvexHull() 
+ * stop recursing and use leafHull() instead. Values of 3 or less disable the leaf kernel.
+ * Can be tuned for the current machine with tuneLeafCutoff().
+ */
+long long leafCutoff = 32;
+
+/// Largest interval size supported by the leaf kernel, leafCutoff is clamped to this value
+const long long maxLeafCutoff = 256;
+
+/**
+ * \brief Compute the upper or lower hull of a small interval with a monotone chain
+ * 
+ * The chain is built over a fixed size stack buffer of N indices, so no memory is 
+ * allocated other than the returned PointList. N must not be smaller than the 
+ * number of points in the interval. Collinear and duplicate points are dropped 
+ * from the chain, as done by the tangents while merging.
+ * 
+ * \tparam N size of the stack buffer
+ * \tparam upper true to compute the upper hull, false for the lower hull
+ * \param input input points which are sorted w.r.t x coordinate
+ * \param start start index of interval over which hull is computed
+ * \param end ending index of interval over which hull is computed (inclusive)
+ * \return PointList with all Points present on the hull of given interval (in clockwise order)
+ */
+template <int N, bool upper>
+PointList leafHull(PointList &input, long long start, long long end) {
+    long long chain[N]; // indices of points present on the chain
+    int top = 0;
+    for (long long i=start;i<=end;i++) {
+        // pop the last point while the chain does not turn strictly at it
+        while (top >= 2 && orient(input[chain[top-2]], input[chain[top-1]], input[i]) != (upper ? -1 : 1))
+            top--;
+        chain[top++] = i;
+    }
+    PointList output;
+    output.reserve(top);
+    for (int i=0;i<top;i++) output.push_back(input[chain[i]]);
+    return output;
+}
+
+/**
+ * \brief Dispatch an interval to the smallest leafHull() specialization that can hold it
+ * \param input input points which are sorted w.r.t x coordinate
+ * \param start start index of interval over which hull is computed
+ * \param end ending index of interval over which hull is computed (inclusive)
+ * \param upper true to compute the upper hull, false for the lower hull
+ * \return PointList with all Points present on the hull of given interval (in clockwise order)
+ */
+PointList leafHull(PointList &input, long long start, long long end, bool upper) {
+    long long n = end-start+1;
+    if (n <= 8) return upper ? leafHull<8, true>(input, start, end) : leafHull<8, false>(input, start, end);
+    if (n <= 16) return upper ? leafHull<16, true>(input, start, end) : leafHull<16, false>(input, start, end);
+    if (n <= 32) return upper ? leafHull<32, true>(input, start, end) : leafHull<32, false>(input, start, end);
+    if (n <= 64) return upper ? leafHull<64, true>(input, start, end) : leafHull<64, false>(input, start, end);
+    if (n <= 128) return upper ? leafHull<128, true>(input, start, end) : leafHull<128, false>(input, start, end);
+    return upper ? leafHull<maxLeafCutoff, true>(input, start, end) : leafHull<maxLeafCutoff, false>(input, start, end);
+}
+
 /**
  * \brief Recursive function to compute the upper hull of the left half and right half points then merge them with upper tangent
  * \param input input points which are sorted w.r.t x coordinate
  * \param start start index of interval over which upper hull is computed
  * \param end ending index of interval over which upper hull is computed
  * \return PointList with all Points present on upper hull of given interval (in clockwise order)
+ * 
+ * Intervals of at most leafCutoff points are handed over to leafHull() instead of recursing further.
  */
 PointList upperConvexHull(PointList &input, int start, int end) {
     PointList output;
+    if (end-start+1 > 3 && end-start+1 <= min(leafCutoff, maxLeafCutoff)) { // small interval
+        return leafHull(input, start, end, true);
+    }
     if (end-start+1 <= 3) { // base case
         if (end-start+1 == 3 && orient(input[start], input[start+1], input[end])>0) {// problematic
             output.push_back(input[start]);
@@ -140,6 +217,7 @@ PointList upperConvexHull(PointList &input, int start, int end) {
     long long mid = (start + end)/2;
     PointList lHull = upperConvexHull(input, start, mid); // left hull
     PointList rHull = upperConvexHull(input, mid+1, end); // right hull
+    PROFILE_SCOPE("merge");
     pair<long long, long long> ut = upperTangent(lHull, rHull);
     for (long long i=0;i<=ut.first;i++) output.push_back(lHull[i]);
     for (long long i=ut.second;i<rHull.size();i++) output.push_back(rHull[i]);
@@ -152,9 +230,14 @@ PointList upperConvexHull(PointList &input, int start, int end) {
  * \param start start index of interval over which lower hull is computed
  * \param end ending index of interval over which lower hull is computed
  * \return PointList with all Points present on lower hull of given interval (in clockwise order)
+ * 
+ * Intervals of at most leafCutoff points are handed over to leafHull() instead of recursing further.
  */
 PointList lowerConvexHull(PointList &input, int start, int end) {
     PointList output;
+    if (end-start+1 > 3 && end-start+1 <= min(leafCutoff, maxLeafCutoff)) { // small interval
+        return leafHull(input, start, end, false);
+    }
     if (end-start+1 <= 3) { // base case
         if (end-start+1 == 3 && orient(input[start], input[start+1], input[end])<0) {// problematic
             output.push_back(input[start]);
@@ -168,6 +251,7 @@ PointList lowerConvexHull(PointList &input, int start, int end) {
     long long mid = start + ((end - start)/2); // = (start + end)/2
     PointList lHull = lowerConvexHull(input, start, mid); // left hull
     PointList rHull = lowerConvexHull(input, mid+1, end); // right hull
+    PROFILE_SCOPE("merge");
     pair<long long, long long> lt = lowerTangent(lHull, rHull);
     for (long long i=0;i<=lt.first;i++) output.push_back(lHull[i]);
     for (long long i=lt.second;i<rHull.size();i++) output.push_back(rHull[i]);
@@ -181,10 +265,78 @@ PointList lowerConvexHull(PointList &input, int start, int end) {
  */
 PointList convexHull(PointList &input) {
     xAxisSort(input);
-    PointList uHull = upperConvexHull(input, 0, input.size()-1);
-    PointList lHull = lowerConvexHull(input, 0, input.size()-1);
+    PointList uHull, lHull;
+    {
+        PROFILE_SCOPE("recurse");
+        uHull = upperConvexHull(input, 0, input.size()-1);
+        lHull = lowerConvexHull(input, 0, input.size()-1);
+    }
     PointList output = combineHulls(uHull, lHull);
     return output;
 }
 
+/**
+ * \brief Pick the leafCutoff which computes convex hulls fastest on the current machine
+ * 
+ * Every candidate cutoff is timed on the same set of uniformly random points and the 
+ * fastest of them (best of a few runs) is assigned to leafCutoff.
+ * 
+ * \param n number of random points used for timing
+ * \param runs number of times each candidate is timed
+ * \return long long the selected cutoff
+ */
+long long tuneLeafCutoff(long long n = 200000, int runs = 5) {
+    const long long candidates[] = {3, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256};
+    mt19937 gen(202);
+    uniform_real_distribution<double> coord(-1e4, 1e4);
+    PointList points;
+    for (long long i=0;i<n;i++) points.emplace_back(coord(gen), coord(gen));
+    xAxisSort(points);
+
+    long long best = leafCutoff;
+    double bestTime = -1;
+    for (long long cutoff: candidates) {
+        leafCutoff = cutoff;
+        double time = -1;
+        for (int r=0;r<runs;r++) {
+            auto start = chrono::steady_clock::now();
+            PointList uHull = upperConvexHull(points, 0, points.size()-1);
+            PointList lHull = lowerConvexHull(points, 0, points.size()-1);
+            double elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+            if (time < 0 || elapsed < time) time = elapsed;
+        }
+        if (bestTime < 0 || time < bestTime) {
+            bestTime = time;
+            best = cutoff;
+        }
+    }
+    leafCutoff = best;
+    return best;
+}
+
+/**
+ * \brief Save the current leafCutoff so that later runs can reuse it with loadLeafCutoff()
+ * \param path file to which the cutoff is written
+ * \return true if the file was written
+ */
+bool saveLeafCutoff(const string &path) {
+    ofstream file(path);
+    if (!file.is_open()) return false;
+    file << leafCutoff << "\n";
+    return true;
+}
+
+/**
+ * \brief Load a leafCutoff saved by saveLeafCutoff()
+ * \param path file from which the cutoff is read
+ * \return true if a valid cutoff was read, leafCutoff is left unchanged otherwise
+ */
+bool loadLeafCutoff(const string &path) {
+    ifstream file(path);
+    long long cutoff;
+    if (!(file >> cutoff) || cutoff < 1) return false;
+    leafCutoff = cutoff;
+    return true;
+}
+
 #endif
\ No newline at end of file
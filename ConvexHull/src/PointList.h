@@ -13,6 +13,7 @@
 #include <vector>
 #include <iterator>
 #include "Point.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -26,7 +27,7 @@ using namespace std;
  */
 class PointList {
     private:
-        vector<Point> pts; /**< STL vector object to store points */
+        vector<Point, ProfileAllocator<Point>> pts; /**< STL vector object to store points */
         bool sentinels; /**< boolean to denote if sentinels are present or absent */
         Point lsentinal; /**< Left sentinal point coordinates, auto-determined */
         Point rsentinal; /**< Right sentinal point coordinates, auto-determined */
@@ -41,7 +42,7 @@ class PointList {
          * \brief vector based constructor for Point class
          * \param points vector of Point objects used to initialize PointList
          */
-        PointList(vector<Point> points): pts(points), sentinels(false) {}
+        PointList(vector<Point> points): pts(points.begin(), points.end()), sentinels(false) {}
 
         /**
          * \brief add or remove sentinel nodes
@@ -67,6 +68,11 @@ class PointList {
             return pts.push_back(p);
         }
 
+        /// To provide interface to STL vector's reserve() function
+        void reserve(size_t n) {
+            pts.reserve(n);
+        }
+
         /// To provide interface to STL vector's size() function
         auto size() {
             return pts.size();
@@ -15,6 +15,7 @@
 #include <sstream>
 #include "Point.h"
 #include "PointList.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -26,6 +27,7 @@ using namespace std;
  * \return Orientation: -1 if clockwise, +1 if counter-clockwise and 0 if colinear
  */
 int orient(const Point &p, const Point &q, const Point &r) {
+    PROFILE_COUNT(ORIENT_CALLS);
     // counter clock wise: +ve: upward direction: +ve orient
     double x = ((q.x*(double)r.y-r.x*(double)q.y) - p.x*(double)(r.y-q.y) + p.y*(double)(r.x-q.x));
     if (x == 0) return 0;
@@ -43,6 +45,7 @@ void log(string s) {
  * \return PointList object containing the input points in the given order
  */
 PointList readPoints(int argc, char *argv[]) {
+    PROFILE_SCOPE("parse");
     string current_exec_name = argv[0]; // Name of the current exec program
     vector<string> all_args;
     PointList points;
@@ -57,7 +60,8 @@ PointList readPoints(int argc, char *argv[]) {
     if (argc > 1 && all_args[0] == "help") { // asking help
         cout << "Convex hull generator program.\n"
             << "Input: file with space seperated points as command line argument.\n"
-            << "Output: Counter clockwise order of points on Convex hull written to stdout.\n";
+            << "Output: Counter clockwise order of points on Convex hull written to stdout.\n"
+            << "Run with 'tune' as arg to pick the fastest recursion cutoff for this machine.\n";
         exit(0);
     }
     else if (argc == 1) { // no args
@@ -11,11 +11,21 @@
 #include <iostream>
 #include "Tools.h"
 #include "ConvexHull.h"
+#include "Profiler.h"
 
 using namespace std;
 using namespace std::chrono;
 
 int main(int argc, char *argv[]) {
+    // pick the recursion cutoff for this machine, or reuse a previously tuned one
+    const string cutoffFile = "leafCutoff.txt";
+    if (argc > 1 && string(argv[1]) == "tune") {
+        cout << "Tuned leaf cutoff: " << tuneLeafCutoff() << "\n";
+        if (!saveLeafCutoff(cutoffFile)) cout << "Unable to save cutoff to " << cutoffFile << "\n";
+        return 0;
+    }
+    loadLeafCutoff(cutoffFile);
+
     // start timer
     auto start = high_resolution_clock::now();
 
@@ -37,6 +47,7 @@ int main(int argc, char *argv[]) {
     auto run_time = duration_cast<microseconds>(lap2 - lap1);
     cout << "Time taken for input: " << input_time.count() << "\n";
     cout << "Time taken for computing convex hull: " << run_time.count() << "\n";
+    PROFILE_REPORT();
     return 0;
 }
 
@@ -60,6 +71,7 @@ int main(int argc, char *argv[]) {
  * 3) Run the executable using <em>./a.out</em> (on linux) <br>
  *    3.1) The executable takes a dataset from command line argument. For example, to use an existing dataset, run <em>./a.out ../datasets/edge.txt</em> <br>
  *    3.2) If no command-line argument is given, it takes input from the shell directly (stdin) <br>
+ *    3.3) Run <em>./a.out tune</em> once to pick the fastest recursion cutoff for the machine, it is saved to leafCutoff.txt and reused by later runs <br>
  * 
  * <br> Performance of the algorithm is documented in the report<br>
  * 
@@ -0,0 +1,224 @@
+/**
+ * @file Circulators.h
+ * @brief This file contains iterators walking around faces and vertices of a DCEL
+ *
+ * Walking a face or a vertex star only needs the next and twin pointers of the half-edges,
+ * yet going through heMap costs a map lookup per vertex. The circulators below follow the
+ * pointers directly, hold two pointers and a counter, and never allocate. Together with the
+ * ranges over all faces, vertices and half-edges of a DCEL, they can be used in range-for
+ * loops and passed to the standard algorithms.
+ */
+
+#ifndef __CIRCULATORS_H__
+#define __CIRCULATORS_H__
+
+#include <vector>
+#include <cstddef>
+#include <iterator>
+
+#include "Geometry.h"
+#include "DCEL.h"
+
+using namespace std;
+
+/**
+ * @brief Pair of iterators usable in a range-for loop
+ *
+ * @tparam It iterator type
+ */
+template <class It>
+struct Range {
+    It first, last;
+
+    It begin() const { return first; }
+    It end() const { return last; }
+};
+
+/**
+ * @class Circulator
+ * @brief Forward iterator over a cycle of half-edges
+ *
+ * Starting from a half-edge, Step::advance() is applied until the first half-edge comes
+ * back. The number of completed turns is kept so that begin and end, which point to the
+ * same half-edge, are different iterators.
+ *
+ * @tparam Step type with a static HalfEdge* advance(HalfEdge*) giving the next half-edge of the cycle
+ */
+template <class Step>
+class Circulator {
+    private:
+        HalfEdge *current; /**< half-edge pointed to */
+        HalfEdge *start; /**< first half-edge of the cycle */
+        unsigned long turns; /**< number of times the walk came back to start */
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef HalfEdge *value_type;
+        typedef ptrdiff_t difference_type;
+        typedef HalfEdge *const *pointer;
+        typedef HalfEdge *const &reference;
+
+        /**
+         * @brief Construct a new Circulator object pointing to nothing
+         *
+         */
+        Circulator(): current(nullptr), start(nullptr), turns(0) {}
+
+        /**
+         * @brief Construct a new Circulator object
+         *
+         * @param Start first half-edge of the cycle, nullptr for an empty cycle
+         * @param Turns 0 for the beginning of the cycle, 1 for its end
+         */
+        Circulator(HalfEdge *Start, unsigned long Turns): current(Start), start(Start), turns(Start ? Turns : 0) {}
+
+        reference operator*() const { return current; }
+        pointer operator->() const { return &current; }
+
+        Circulator& operator++() {
+            current = Step::advance(current);
+            if (current == start) turns++;
+            return *this;
+        }
+
+        Circulator operator++(int) {
+            Circulator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const Circulator &c) const { return current == c.current && turns == c.turns; }
+        bool operator!=(const Circulator &c) const { return !(*this == c); }
+};
+
+/// Step going around a face, following next pointers (counter-clockwise for bounded faces)
+struct FaceStep {
+    static HalfEdge* advance(HalfEdge *h) { return h->next; }
+};
+
+/// Step going clockwise around the tail of a half-edge, as ordered in heMap
+struct StarStep {
+    static HalfEdge* advance(HalfEdge *h) { return h->twin->next; }
+};
+
+typedef Circulator<FaceStep> FaceCirculator;
+typedef Circulator<StarStep> StarCirculator;
+
+/**
+ * @brief Half-edges around a face, starting at its representative
+ *
+ * @param f Face to be walked
+ * @return Range<FaceCirculator> the half-edges having f to their left
+ */
+Range<FaceCirculator> faceEdges(const Face *f) {
+    return Range<FaceCirculator>{FaceCirculator(f->rep, 0), FaceCirculator(f->rep, 1)};
+}
+
+/**
+ * @brief Half-edges leaving a vertex in clockwise order, starting at its representative
+ *
+ * Gives the same half-edges as heMap[v], in the same cyclic order, without the lookup.
+ *
+ * @param v Vertex to be walked around
+ * @return Range<StarCirculator> the half-edges whose tail is v, empty if v has no edge
+ */
+Range<StarCirculator> vertexStar(const Vertex *v) {
+    return Range<StarCirculator>{StarCirculator(v->rep, 0), StarCirculator(v->rep, 1)};
+}
+
+/**
+ * @class HalfEdgeIterator
+ * @brief Forward iterator over all the half-edges of a DCEL, vertex by vertex
+ *
+ * Half-edges are visited star after star in the order of DCEL::vertices. For parallel
+ * loops over half-edges, it is better to split allVertices() among the threads and walk
+ * vertexStar() of each vertex, since allVertices() is random access.
+ */
+class HalfEdgeIterator {
+    private:
+        const vector<Vertex *> *vertices; /**< vertices of the DCEL */
+        unsigned long index; /**< index of the vertex whose star is walked */
+        StarCirculator around; /**< position in the star of that vertex */
+
+        /// Move to the first vertex with a non empty star, from the current one
+        void skipEmpty() {
+            while (index < vertices->size() && (*vertices)[index]->rep == nullptr) index++;
+            around = (index < vertices->size()) ? StarCirculator((*vertices)[index]->rep, 0) : StarCirculator();
+        }
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef HalfEdge *value_type;
+        typedef ptrdiff_t difference_type;
+        typedef HalfEdge *const *pointer;
+        typedef HalfEdge *const &reference;
+
+        /**
+         * @brief Construct a new HalfEdgeIterator object pointing to nothing
+         *
+         */
+        HalfEdgeIterator(): vertices(nullptr), index(0) {}
+
+        /**
+         * @brief Construct a new HalfEdgeIterator object
+         *
+         * @param Vertices vertices of the DCEL
+         * @param Index index of the first vertex to be walked, Vertices->size() for the end
+         */
+        HalfEdgeIterator(const vector<Vertex *> *Vertices, unsigned long Index): vertices(Vertices), index(Index) {
+            skipEmpty();
+        }
+
+        reference operator*() const { return *around; }
+        pointer operator->() const { return &*around; }
+
+        HalfEdgeIterator& operator++() {
+            ++around;
+            if (around == StarCirculator((*vertices)[index]->rep, 1)) {
+                index++;
+                skipEmpty();
+            }
+            return *this;
+        }
+
+        HalfEdgeIterator operator++(int) {
+            HalfEdgeIterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const HalfEdgeIterator &i) const { return index == i.index && around == i.around; }
+        bool operator!=(const HalfEdgeIterator &i) const { return !(*this == i); }
+};
+
+/**
+ * @brief All the faces of a DCEL, in order of id
+ *
+ * @param dcel DCEL object
+ * @return Range<vector<Face *>::const_iterator> random access range over the faces
+ */
+Range<vector<Face *>::const_iterator> allFaces(const DCEL &dcel) {
+    return Range<vector<Face *>::const_iterator>{dcel.faces.begin(), dcel.faces.end()};
+}
+
+/**
+ * @brief All the vertices of a DCEL
+ *
+ * @param dcel DCEL object
+ * @return Range<vector<Vertex *>::const_iterator> random access range over the vertices
+ */
+Range<vector<Vertex *>::const_iterator> allVertices(const DCEL &dcel) {
+    return Range<vector<Vertex *>::const_iterator>{dcel.vertices.begin(), dcel.vertices.end()};
+}
+
+/**
+ * @brief All the half-edges of a DCEL
+ *
+ * @param dcel DCEL object
+ * @return Range<HalfEdgeIterator> forward range over the half-edges, see HalfEdgeIterator
+ */
+Range<HalfEdgeIterator> allHalfEdges(const DCEL &dcel) {
+    return Range<HalfEdgeIterator>{HalfEdgeIterator(&dcel.vertices, 0), HalfEdgeIterator(&dcel.vertices, dcel.vertices.size())};
+}
+
+#endif
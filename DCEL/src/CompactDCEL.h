@@ -0,0 +1,272 @@
+/**
+ * @file CompactDCEL.h
+ * @brief This file contains a compact, index based representation of the DCEL
+ *
+ * The pointer based DCEL allocates every Vertex, HalfEdge and Face separately and keeps
+ * the vertex stars in a map of vectors. CompactDCEL stores the same planar subdivision in
+ * a handful of contiguous arrays indexed with 32-bit integers, which takes a fraction of
+ * the memory and is much faster to traverse.
+ */
+
+#ifndef __COMPACTDCEL_H__
+#define __COMPACTDCEL_H__
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Geometry.h"
+#include "VertexGrid.h"
+#include "Predicates.h"
+#include "DCEL.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @class CompactDCEL
+ * @brief Index based DCEL stored as structure of arrays
+ *
+ * Vertices, half-edges and faces are identified by their index. The two half-edges of
+ * an edge are stored next to each other so that the twin of half-edge h is h^1, and
+ * the head of h is the origin of its twin, hence neither is stored. The half-edges
+ * leaving each vertex are kept in clockwise order in CSR form: the star of vertex v is
+ * star[starOffset[v]] ... star[starOffset[v+1]-1].
+ *
+ * Memory used per edge is 2 * 4 * 4 = 32 bytes (origin, next, face and star entry of
+ * both half-edges) and 20 bytes per vertex (coordinates and star offset).
+ */
+class CompactDCEL {
+    public:
+        static const uint32_t none = 0xFFFFFFFF; /**< index used to denote a missing element */
+
+        vector<double> x; /**< x coordinate of each vertex */
+        vector<double> y; /**< y coordinate of each vertex */
+        vector<uint32_t> starOffset; /**< CSR offsets into star, one more entry than vertices */
+        vector<uint32_t> star; /**< half-edges leaving each vertex in clockwise order */
+        vector<uint32_t> origin; /**< tail vertex of each half-edge */
+        vector<uint32_t> nextEdge; /**< next half-edge around the face of each half-edge */
+        vector<uint32_t> face; /**< face to the left of each half-edge */
+        vector<uint32_t> faceRep; /**< representative half-edge of each face */
+
+        /**
+         * @brief Construct a new empty CompactDCEL object
+         *
+         */
+        CompactDCEL() {}
+
+        /**
+         * @brief Build the compact DCEL directly from a list of edges
+         *
+         * Equal endpoints (Vertex::operator==) are merged into one vertex as done by DCEL.
+         * Vertex indices follow the order in which vertices first appear in the edge list
+         * and half-edge 2i (2i+1) goes from the first (second) endpoint of edge i.
+         *
+         * @param edgelist a List of Edge objects which are used to build the structure
+         */
+        CompactDCEL(vector<Edge> &edgelist) {
+            PROFILE_SCOPE("build");
+            VertexGrid grid;
+            grid.reserve(edgelist.size());
+            origin.resize(2 * edgelist.size());
+            for (unsigned long i = 0; i < edgelist.size(); i++) {
+                // both endpoints are looked up before either is added, as done by DCEL
+                long a = findVertex(edgelist[i].src, grid), b = findVertex(edgelist[i].dst, grid);
+                origin[2 * i] = (a == -1) ? addVertex(edgelist[i].src, grid) : a;
+                origin[2 * i + 1] = (b == -1) ? addVertex(edgelist[i].dst, grid) : b;
+            }
+            buildStars();
+            linkFaces();
+        }
+
+        /**
+         * @brief Build the compact DCEL from an existing pointer based DCEL
+         *
+         * Vertex i is dcel.vertices[i] and face i is the face with id i. Stars and face
+         * cycles are copied as they are, so both structures describe the same subdivision.
+         *
+         * @param dcel DCEL object to be converted
+         */
+        CompactDCEL(DCEL &dcel) {
+            PROFILE_SCOPE("convert");
+            unordered_map<const Vertex *, uint32_t> vertexId;
+            unordered_map<const HalfEdge *, uint32_t> edgeId;
+            for (Vertex *v: dcel.vertices) {
+                vertexId[v] = x.size();
+                x.push_back(v->x);
+                y.push_back(v->y);
+            }
+            starOffset.push_back(0);
+            for (Vertex *v: dcel.vertices) { // number half-edges so that twins are h and h^1
+                for (HalfEdge *he: dcel.heMap[v]) {
+                    if (edgeId.count(he)) continue;
+                    edgeId[he] = origin.size();
+                    edgeId[he->twin] = origin.size() + 1;
+                    origin.push_back(vertexId[he->tail]);
+                    origin.push_back(vertexId[he->head]);
+                }
+            }
+            for (Vertex *v: dcel.vertices) {
+                for (HalfEdge *he: dcel.heMap[v]) star.push_back(edgeId[he]);
+                starOffset.push_back(star.size());
+            }
+            nextEdge.resize(origin.size());
+            face.resize(origin.size());
+            faceRep.resize(dcel.faces.size());
+            for (auto &p: edgeId) {
+                nextEdge[p.second] = edgeId[p.first->next];
+                face[p.second] = p.first->face->id;
+            }
+            for (Face *f: dcel.faces) faceRep[f->id] = edgeId[f->rep];
+        }
+
+        /// Number of vertices in the structure
+        uint32_t numVertices() const { return x.size(); }
+
+        /// Number of half-edges in the structure (twice the number of edges)
+        uint32_t numHalfEdges() const { return origin.size(); }
+
+        /// Number of faces in the structure
+        uint32_t numFaces() const { return faceRep.size(); }
+
+        /// Twin of the given half-edge
+        static uint32_t twin(uint32_t h) { return h ^ 1; }
+
+        /// Tail vertex of the given half-edge
+        uint32_t tail(uint32_t h) const { return origin[h]; }
+
+        /// Head vertex of the given half-edge
+        uint32_t head(uint32_t h) const { return origin[h ^ 1]; }
+
+        /// Next half-edge around the face of the given half-edge
+        uint32_t next(uint32_t h) const { return nextEdge[h]; }
+
+        /**
+         * @brief Previous half-edge around the face of the given half-edge
+         *
+         * prev is not stored, it is found in O(degree) from the star of the tail vertex as
+         * the twin of the half-edge preceding h in clockwise order.
+         *
+         * @param h half-edge whose previous half-edge is required
+         * @return uint32_t half-edge p such that next(p) == h
+         */
+        uint32_t prev(uint32_t h) const {
+            uint32_t v = origin[h], s = starOffset[v], e = starOffset[v + 1];
+            for (uint32_t i = s; i < e; i++)
+                if (star[i] == h) return twin(star[(i == s) ? e - 1 : i - 1]);
+            return none;
+        }
+
+        /**
+         * @brief Print the directional halfedges which surround the face
+         *
+         * Output format is the same as DCEL::printBoundaryEdges()
+         *
+         * @param f index of the face
+         */
+        void printBoundaryEdges(uint32_t f) const {
+            uint32_t h = faceRep[f];
+            do {
+                cout << "HEdge: " << Vertex(x[tail(h)], y[tail(h)]) << " -> " << Vertex(x[head(h)], y[head(h)]) << "\n";
+                h = nextEdge[h];
+            } while (h != faceRep[f]);
+            cout << "\n";
+        }
+
+        /**
+         * @brief Memory used by the arrays of this structure
+         *
+         * @return unsigned long size in bytes
+         */
+        unsigned long bytes() const {
+            return x.capacity() * sizeof(double) + y.capacity() * sizeof(double)
+                + (starOffset.capacity() + star.capacity() + origin.capacity() + nextEdge.capacity()
+                + face.capacity() + faceRep.capacity()) * sizeof(uint32_t);
+        }
+
+    private:
+        /**
+         * @brief Find the vertex equal to the given vertex
+         *
+         * @param v Vertex object to be searched
+         * @param grid grid over the vertices created so far
+         * @return long index of the matching vertex, -1 if there is none
+         */
+        long findVertex(const Vertex &v, const VertexGrid &grid) const {
+            return grid.search(v, [&](unsigned long i) {
+                return abs(x[i] - v.x) < epsillion && abs(y[i] - v.y) < epsillion;
+            });
+        }
+
+        /**
+         * @brief Create a new vertex
+         *
+         * @param v Vertex object to be added
+         * @param grid grid over the vertices created so far
+         * @return uint32_t index of the new vertex
+         */
+        uint32_t addVertex(const Vertex &v, VertexGrid &grid) {
+            grid.insert(v, x.size());
+            x.push_back(v.x);
+            y.push_back(v.y);
+            return x.size() - 1;
+        }
+
+        /**
+         * @brief Group half-edges by their origin in CSR form and sort each star clockwise
+         *
+         */
+        void buildStars() {
+            PROFILE_SCOPE("sort");
+            starOffset.assign(x.size() + 1, 0);
+            for (uint32_t v: origin) starOffset[v + 1]++;
+            for (uint32_t v = 0; v < x.size(); v++) starOffset[v + 1] += starOffset[v];
+            star.resize(origin.size());
+            vector<uint32_t> fill(starOffset.begin(), starOffset.end() - 1);
+            for (uint32_t h = 0; h < origin.size(); h++) star[fill[origin[h]]++] = h;
+            vector<StarKey> key(origin.size());
+            for (uint32_t h = 0; h < origin.size(); h++)
+                key[h] = StarKey(x[tail(h)], y[tail(h)], x[head(h)], y[head(h)]);
+            for (uint32_t v = 0; v < x.size(); v++) { // same order as compare() in DCEL.h
+                sort(star.begin() + starOffset[v], star.begin() + starOffset[v + 1],
+                    [&](uint32_t p, uint32_t q) { return starBefore(key[p], key[q]); });
+            }
+        }
+
+        /**
+         * @brief Link consecutive half-edges of every star and assign a face to every cycle
+         *
+         */
+        void linkFaces() {
+            {
+                PROFILE_SCOPE("link");
+                nextEdge.resize(origin.size());
+                // for consecutive half-edges e1, e2 in clockwise order: e1->twin->next = e2
+                for (uint32_t v = 0; v < x.size(); v++) {
+                    uint32_t s = starOffset[v], e = starOffset[v + 1];
+                    for (uint32_t i = s; i < e; i++)
+                        nextEdge[twin(star[i])] = star[(i + 1 == e) ? s : i + 1];
+                }
+            }
+            PROFILE_SCOPE("face assignment");
+            face.assign(origin.size(), none);
+            faceRep.clear();
+            for (uint32_t h: star) {
+                if (face[h] != none) continue;
+                uint32_t f = faceRep.size();
+                faceRep.push_back(h);
+                uint32_t t = h;
+                do {
+                    face[t] = f;
+                    t = nextEdge[t];
+                } while (t != h);
+            }
+        }
+};
+
+const uint32_t CompactDCEL::none;
+
+#endif
@@ -5,108 +5,678 @@
 #include <set>
 #include <vector>
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "Geometry.h"
+#include "VertexGrid.h"
+#include "Pool.h"
+#include "Parallel.h"
+#include "Hilbert.h"
+#include "Predicates.h"
+#include "Profiler.h"
 
 using namespace std;
 
-bool compare(const HalfEdge *p, const HalfEdge *q) { // needs revision
-    return p->angle > q->angle;
+/**
+ * @brief Key giving the clockwise position of a half-edge around its tail
+ * 
+ * @param he HalfEdge object
+ * @return StarKey key to be compared with starBefore()
+ */
+StarKey starKey(const HalfEdge *he) {
+    return StarKey(he->tail->x, he->tail->y, he->head->x, he->head->y);
+}
+
+/**
+ * @brief Compare two half-edges leaving the same vertex in clockwise order
+ * 
+ * Half-edges are ordered by decreasing angle with the positive x axis, using exact
+ * predicates and no trigonometric function (see StarKey).
+ * 
+ * @param p first HalfEdge
+ * @param q second HalfEdge, with the same tail as p
+ * @return true if p comes strictly before q in clockwise order
+ */
+bool compare(const HalfEdge *p, const HalfEdge *q) {
+    return starBefore(starKey(p), starKey(q));
 }
 
+/**
+ * @brief Sort the half-edges leaving a vertex in clockwise order
+ * 
+ * Batched version of sort(star, compare): the key of every half-edge is computed once,
+ * the keys are sorted in a contiguous buffer and the half-edges are written back.
+ * 
+ * @param star list of half-edges sharing the same tail
+ * @param scratch buffer reused between calls to avoid allocations
+ */
+void sortStar(vector<HalfEdge *> &star, vector<pair<StarKey, HalfEdge *>> &scratch) {
+    if (star.size() < 2) return;
+    scratch.clear();
+    for (HalfEdge *he: star) scratch.emplace_back(starKey(he), he);
+    sort(scratch.begin(), scratch.end(), [](const pair<StarKey, HalfEdge *> &p, const pair<StarKey, HalfEdge *> &q) {
+        return starBefore(p.first, q.first);
+    });
+    for (unsigned long i = 0; i < star.size(); i++) star[i] = scratch[i].second;
+}
+
+/**
+ * @brief Functor ordering the half-edges leaving a vertex in clockwise order, see compare()
+ * 
+ */
+struct StarOrder {
+    bool operator()(const HalfEdge *p, const HalfEdge *q) const {
+        return compare(p, q);
+    }
+};
+
+/// Half-edges leaving a vertex, kept in clockwise order so that insertion and lookup are O(log d)
+typedef multiset<HalfEdge *, StarOrder, ProfileAllocator<HalfEdge *>> Star;
+
+/**
+ * @class DCELObserver
+ * @brief Interface through which a DCEL reports the changes made by its edit operations
+ * 
+ * Structures derived from a DCEL, such as caches and indexes, register themselves with
+ * DCEL::addObserver() and are called back by every edit so that they can update only what
+ * changed. Edges about to be removed or moved are reported before the edit, while their
+ * geometry is still the old one; all other calls are made once the DCEL is consistent
+ * again. The default implementations do nothing.
+ * 
+ */
+class DCELObserver {
+    public:
+        /**
+         * @brief Called when the boundary cycle of a face was created or changed
+         * 
+         * @param f Face whose cycle changed, f->id is its current id
+         */
+        virtual void faceChanged(Face * /*f*/) {}
+
+        /**
+         * @brief Called when a face was removed
+         * 
+         * The last face takes the id of the removed face (see DCEL::faces), so the face which
+         * had id last now has id id, unless both are equal.
+         * 
+         * @param id id of the removed face
+         * @param last previous id of the face which now has id id
+         */
+        virtual void faceRemoved(unsigned long /*id*/, unsigned long /*last*/) {}
+
+        /**
+         * @brief Called when an edge was added, or moved by an edit
+         * 
+         * @param h one of the two half-edges of the edge
+         */
+        virtual void edgeAdded(HalfEdge * /*h*/) {}
+
+        /**
+         * @brief Called before an edge is removed, or moved by an edit
+         * 
+         * A moved edge is reported by edgeRemoved() before the edit and by edgeAdded()
+         * after it, possibly through its other half-edge.
+         * 
+         * @param h one of the two half-edges of the edge
+         */
+        virtual void edgeRemoved(HalfEdge * /*h*/) {}
+
+        virtual ~DCELObserver() {}
+};
+
 /**
  * @class DCEL
  * @brief The main class for the DCEL data structure
  * 
  * This is the main DCEL data structure. All basic geometric structures are created dynamically
  * and stored as pointers so that all structures can refer to each other without extra storage.
+ * The objects are allocated from the pools of a DCELArena, either owned by the DCEL or supplied
+ * by the user, so that they lie close together in memory and are released in bulk.
  * 
  */
 class DCEL {
     private:
         unsigned long totalFaces; /**< Total number of faces present in the current planar graph */
+        VertexGrid grid; /**< Spatial hash grid over vertices to find duplicates in expected O(1) */
+        DCELArena *arena; /**< Pools from which all Vertex, HalfEdge and Face objects are allocated */
+        bool ownsArena; /**< true if the arena was created by this DCEL and must be released with it */
+        vector<DCELObserver *> observers; /**< Objects notified of the changes made by edit operations */
 
         Vertex* inSet(const Vertex &a) {
-            for (auto &v: vertices)
-                if (*v == a) return v;
-            return nullptr;
+            return grid.find(a, vertices);
         }
 
-    public:
-        map<Vertex *, vector<HalfEdge *>> heMap; /**< Hash Map to store list of HalfEdge objects incident at each vertex */
-        vector<Vertex *> vertices; /**< List of pointer to all available vertices */
-        vector<Face *> faces; /**< List of pointers to all abailable faces */
+        /**
+         * @brief Find the index of the vertex equal to the given vertex
+         * 
+         * @param a Vertex object to be searched
+         * @return long index of the matching vertex in vertices, -1 if there is none
+         */
+        long findVertex(const Vertex &a) const {
+            return grid.search(a, [&](unsigned long i) { return *vertices[i] == a; });
+        }
 
         /**
-         * @brief Construct a new DCEL object form the input list of edges
+         * @brief Register a new Vertex object with the DCEL
          * 
-         * @param edgelist a LIst of Edge objects which are used to build the DCEL structure
+         * The vertex is added to the list of vertices, the HalfEdge map and the vertex grid.
+         * 
+         * @param v Pointer to the Vertex object to be registered
+         * @return Star& the (empty) star of the vertex in heMap
          */
-        DCEL(vector<Edge> &edgelist) {
-            // For each edge,
-            // Add half edge to the vertex list of its source
-            for (Edge &edge: edgelist) {
-                // cout << "Processing: " << edge.src << " " << edge.dst << "\n";
-                Vertex *a = inSet(edge.src);
-                Vertex *b = inSet(edge.dst);
-                if (a == nullptr) {
-                    a = new Vertex(edge.src);   
-                    heMap[a] = vector<HalfEdge *>{};
-                    vertices.push_back(a);
+        Star& registerVertex(Vertex *v) {
+            Star &star = heMap[v];
+            grid.insert(*v, vertices.size());
+            vertices.push_back(v);
+            return star;
+        }
+
+        /**
+         * @brief Create the two twin HalfEdge objects of an edge
+         * 
+         * Both half-edges are allocated one after the other from the arena, their twin
+         * pointers are set and all other links are left for the caller to fill.
+         * 
+         * @param a tail Vertex of the returned half-edge
+         * @param b head Vertex of the returned half-edge
+         * @return HalfEdge* the half-edge from a to b
+         */
+        HalfEdge* newEdge(Vertex *a, Vertex *b) {
+            HalfEdge *ab = arena->halfEdges.create(a, b);
+            HalfEdge *ba = arena->halfEdges.create(b, a);
+            ab->twin = ba;
+            ba->twin = ab;
+            return ab;
+        }
+
+        /**
+         * @brief Find the position of a half-edge in the star of its tail
+         * 
+         * @param h HalfEdge leaving the vertex
+         * @return Star::iterator iterator to h in heMap[h->tail]
+         */
+        Star::iterator findInStar(HalfEdge *h) {
+            auto range = heMap[const_cast<Vertex *>(h->tail)].equal_range(h);
+            for (auto i = range.first; i != range.second; i++)
+                if (*i == h) return i;
+            return range.second;
+        }
+
+        /**
+         * @brief Link a half-edge of a star with its clockwise neighbours
+         * 
+         * For the neighbours p and s of h in clockwise order, sets p->twin->next = h and
+         * h->twin->next = s (and the matching prev pointers). Faces are not updated.
+         * 
+         * @param h HalfEdge already present in the star of its tail
+         */
+        void relink(HalfEdge *h) {
+            Star &star = heMap[const_cast<Vertex *>(h->tail)];
+            auto i = findInStar(h);
+            HalfEdge *p = *prev((i == star.begin()) ? star.end() : i);
+            auto n = next(i);
+            HalfEdge *s = *((n == star.end()) ? star.begin() : n);
+            p->twin->next = h;
+            h->prev = p->twin;
+            h->twin->next = s;
+            s->prev = h->twin;
+        }
+
+        /**
+         * @brief Insert a half-edge into the star of its tail and link it with its neighbours
+         * 
+         * The half-edge is placed between its clockwise neighbours p and s, setting
+         * p->twin->next = h and h->twin->next = s. Faces are not updated. Takes O(log d)
+         * for a tail of degree d.
+         * 
+         * @param h HalfEdge to be inserted
+         */
+        void linkIntoStar(HalfEdge *h) {
+            Vertex *v = const_cast<Vertex *>(h->tail);
+            heMap[v].insert(h);
+            relink(h);
+            if (v->rep == nullptr) v->rep = h;
+        }
+
+        /**
+         * @brief Remove a half-edge from the star of its tail
+         * 
+         * The links of the remaining half-edges are not updated.
+         * 
+         * @param h HalfEdge to be removed
+         */
+        void eraseFromStar(HalfEdge *h) {
+            Vertex *v = const_cast<Vertex *>(h->tail);
+            Star &star = heMap[v];
+            star.erase(findInStar(h));
+            if (v->rep == h) v->rep = star.empty() ? nullptr : *star.begin();
+        }
+
+        /**
+         * @brief Cut an edge out of its face cycles and vertex stars
+         * 
+         * The half-edges around the edge are linked to each other, skipping it. Faces are not
+         * updated and the half-edges are not freed; their neighbours and faces are appended
+         * to seeds and dropped so that relabelFaces() can fix the cycles afterwards.
+         * 
+         * @param h one of the two half-edges of the edge
+         * @param seeds half-edges on the cycles changed by the removal
+         * @param dropped faces which may not be used anymore after the removal
+         */
+        void unlinkEdge(HalfEdge *h, vector<HalfEdge *> &seeds, vector<Face *> &dropped) {
+            HalfEdge *t = h->twin;
+            seeds.insert(seeds.end(), {h->prev, h->next, t->prev, t->next});
+            dropped.push_back(h->face);
+            dropped.push_back(t->face);
+            h->prev->next = t->next;
+            t->next->prev = h->prev;
+            t->prev->next = h->next;
+            h->next->prev = t->prev;
+            eraseFromStar(h);
+            eraseFromStar(t);
+        }
+
+        /**
+         * @brief Remove a vertex with an empty star from the DCEL and free it
+         * 
+         * The last vertex takes the place of the removed one in vertices.
+         * 
+         * @param v Vertex to be removed
+         */
+        void unregisterVertex(Vertex *v) {
+            unsigned long i = grid.search(*v, [&](unsigned long k) { return vertices[k] == v; });
+            unsigned long last = vertices.size() - 1;
+            grid.remove(*v, i);
+            if (i != last) {
+                grid.remove(*vertices[last], last);
+                grid.insert(*vertices[last], i);
+                vertices[i] = vertices[last];
+            }
+            vertices.pop_back();
+            heMap.erase(v);
+            arena->vertices.destroy(v);
+        }
+
+        /**
+         * @brief Give the half-edges of removed edges back to the arena
+         * 
+         * @param removed one half-edge of every removed edge
+         */
+        void freeEdges(const vector<HalfEdge *> &removed) {
+            for (HalfEdge *h: removed) {
+                arena->halfEdges.destroy(h->twin);
+                arena->halfEdges.destroy(h);
+            }
+        }
+
+        /**
+         * @brief Remove a Face object from the DCEL
+         * 
+         * The last face takes the place (and the id) of the removed one, so that the face
+         * with id i is always faces[i].
+         * 
+         * @param f Face to be removed
+         */
+        void removeFace(Face *f) {
+            Face *last = faces.back();
+            unsigned long id = f->id, lastId = last->id;
+            faces[id] = last;
+            last->id = id;
+            faces.pop_back();
+            totalFaces = faces.size();
+            arena->faces.destroy(f);
+            for (DCELObserver *o: observers) o->faceRemoved(id, lastId);
+        }
+
+        /**
+         * @brief Assign faces to the cycles changed by an edit
+         * 
+         * Only the cycles going through the seeds are considered. In a first pass they are
+         * walked once, collecting the faces their half-edges used to have. In a second pass
+         * every such cycle gets the first of these old faces not already taken by another
+         * cycle, or a new face if there is none. Old faces left unused (when cycles were
+         * merged or removed), including the dropped ones, are removed. Takes time linear
+         * in the size of the changed cycles.
+         * 
+         * @param seeds half-edges on the changed cycles, which must all be linked
+         * @param dropped faces of removed half-edges, which are removed if no cycle takes them
+         */
+        void relabelFaces(const vector<HalfEdge *> &seeds, const vector<Face *> &dropped = {}) {
+            Face pending; // marks half-edges whose cycle is waiting for a face
+            vector<HalfEdge *> cycles; // first half-edge of every changed cycle
+            vector<unsigned long> first; // old faces of cycle c are old[first[c]] ... old[first[c+1]-1]
+            vector<Face *> old;
+            for (HalfEdge *h: seeds) {
+                if (h->face == &pending) continue;
+                cycles.push_back(h);
+                first.push_back(old.size());
+                HalfEdge *t = h;
+                do {
+                    if (t->face != nullptr && (old.size() == first.back() || old.back() != t->face))
+                        old.push_back(t->face);
+                    t->face = &pending;
+                    t = t->next;
+                } while (t != h);
+            }
+            first.push_back(old.size());
+            unordered_set<Face *> taken;
+            for (unsigned long c = 0; c < cycles.size(); c++) {
+                Face *f = nullptr;
+                for (unsigned long k = first[c]; k < first[c + 1] && f == nullptr; k++)
+                    if (taken.insert(old[k]).second) f = old[k];
+                if (f == nullptr) {
+                    f = arena->faces.create(faces.size(), cycles[c]);
+                    faces.push_back(f);
+                    totalFaces = faces.size();
+                    taken.insert(f);
                 }
-                if (b == nullptr) {
-                    b = new Vertex(edge.dst);
-                    heMap[b] = vector<HalfEdge *>{};
-                    vertices.push_back(b);
+                f->rep = cycles[c];
+                HalfEdge *t = cycles[c];
+                do {
+                    t->face = f;
+                    t = t->next;
+                } while (t != cycles[c]);
+                for (DCELObserver *o: observers) o->faceChanged(f);
+            }
+            for (Face *f: old) if (taken.insert(f).second) removeFace(f);
+            for (Face *f: dropped) if (taken.insert(f).second) removeFace(f);
+        }
+
+        /**
+         * @brief Build the DCEL from the input list of edges, in its arena
+         * 
+         * @param edgelist a LIst of Edge objects which are used to build the DCEL structure
+         */
+        void build(vector<Edge> &edgelist) {
+            PROFILE_SCOPE("build");
+            vector<vector<HalfEdge *>> lists; // half-edges leaving each vertex, by vertex index
+            vector<Star *> stars; // heMap entry of each vertex
+            {
+                PROFILE_SCOPE("insert");
+                grid.reserve(edgelist.size());
+                // For each edge,
+                // Add half edge to the vertex list of its source
+                for (Edge &edge: edgelist) {
+                    // cout << "Processing: " << edge.src << " " << edge.dst << "\n";
+                    long a = findVertex(edge.src);
+                    long b = findVertex(edge.dst);
+                    if (a == -1) {
+                        a = vertices.size();
+                        stars.push_back(&registerVertex(arena->vertices.create(edge.src)));
+                        lists.emplace_back();
+                    }
+                    if (b == -1) {
+                        b = vertices.size();
+                        stars.push_back(&registerVertex(arena->vertices.create(edge.dst)));
+                        lists.emplace_back();
+                    }
+                    HalfEdge *e12 = newEdge(vertices[a], vertices[b]);
+                    lists[a].emplace_back(e12);
+                    lists[b].emplace_back(e12->twin);
                 }
-                HalfEdge *e12 = new HalfEdge(a, b);
-                HalfEdge *e21 = new HalfEdge(b, a);
-                e12->twin = e21;
-                e21->twin = e12;
-                heMap[a].emplace_back(e12);
-                heMap[b].emplace_back(e21);
             }
             // Sort each vertices half-edge list in clockwise order
-            for (auto &x : heMap) {
-                sort(x.second.begin(), x.second.end(), compare);
+            {
+                PROFILE_SCOPE("sort");
+                vector<pair<StarKey, HalfEdge *>> scratch;
+                for (auto &vhe : lists) {
+                    sortStar(vhe, scratch);
+                }
             }
             // assign next and prev of each half edge
             // for every pair of half-edges e1, e2 in clockwise order,
             // assign e1->twin->next = e2 and e2->prev = e1->twin.
-            for (auto &x : heMap) {
-                Vertex *v = x.first;
-                vector<HalfEdge *> vhe = x.second;
-                // cout << "At Vertex " << *v << "\n";
-                for (unsigned long i = 1; i <= vhe.size(); i++) {
-                    HalfEdge *e1 = vhe[i - 1], *e2;
-                    if (i == vhe.size()) e2 = vhe[0];
-                    else e2 = vhe[i];
-                    e1->twin->next = e2;
-                    e2->prev = e1->twin;
-                }
-                if (vhe.size() == 1) { // ex:case where only 2 vertices, one edge exists
-                    HalfEdge *e = vhe[0];
-                    e->twin->next = e;
-                    e->prev = e->twin;
+            {
+                PROFILE_SCOPE("link");
+                for (unsigned long k = 0; k < vertices.size(); k++) {
+                    Vertex *v = vertices[k];
+                    vector<HalfEdge *> &vhe = lists[k];
+                    // cout << "At Vertex " << *v << "\n";
+                    for (unsigned long i = 1; i <= vhe.size(); i++) {
+                        HalfEdge *e1 = vhe[i - 1], *e2;
+                        if (i == vhe.size()) e2 = vhe[0];
+                        else e2 = vhe[i];
+                        e1->twin->next = e2;
+                        e2->prev = e1->twin;
+                    }
+                    if (vhe.size() == 1) { // ex:case where only 2 vertices, one edge exists
+                        HalfEdge *e = vhe[0];
+                        e->twin->next = e;
+                        e->prev = e->twin;
+                    }
+                    // assign one of half edges as representative/incident
+                    // for the vertex
+                    v->rep = vhe[0];
+                    stars[k]->insert(vhe.begin(), vhe.end());
                 }
-                // assign one of half edges as representative/incident
-                // for the vertex
-                v->rep = vhe[0];
             }
             // assign face to every cycle of half-edges
-            totalFaces = 0;
-            for (auto &x: heMap) { // for all vertices
-                // Vertex *v = x.first;
-                vector<HalfEdge *> &vhe = x.second;
-                for (auto &he: vhe) {            // for all their half-edges
-                    if (he->face == nullptr) {          // if face is undefined
-                        setFace(he);
+            {
+                PROFILE_SCOPE("face assignment");
+                totalFaces = 0;
+                for (auto &vhe: lists) { // for all vertices
+                    for (auto &he: vhe) {            // for all their half-edges
+                        if (he->face == nullptr) {          // if face is undefined
+                            setFace(he);
+                        }
+                    }
+                }
+            }
+            // DCEL complete
+        }
+
+        /**
+         * @brief Build the DCEL from the input list of edges using several threads, in its arena
+         * 
+         * Builds the same planar graph as DCEL(vector<Edge>&). Vertices are merged serially
+         * through the vertex grid, then the half-edges are constructed in parallel, sorted
+         * all together by (origin vertex, clockwise order) with a parallel sort and linked one
+         * vertex per task. Faces are labelled by pointer jumping over the next permutation:
+         * every half-edge repeatedly takes the smallest label found 1, 2, 4, ... steps ahead
+         * until no label changes, at which point each cycle is labelled with its smallest
+         * half-edge. Half-edge 2i (2i+1) leaves the first (second) endpoint of edge i and faces
+         * get their ids in increasing order of their smallest half-edge, which is also their
+         * representative, so the result does not depend on the number of threads.
+         * 
+         * @param edgelist a List of Edge objects which are used to build the DCEL structure
+         * @param threads number of threads to use, at least 1
+         */
+        void build(vector<Edge> &edgelist, unsigned threads) {
+            PROFILE_SCOPE("build");
+            if (threads < 1) threads = 1;
+            unsigned long m = 2 * edgelist.size();
+            vector<unsigned long> origin(m); // index of the tail vertex of each half-edge
+            vector<HalfEdge *> he(m);
+            vector<Star *> stars; // heMap entry of each vertex
+            {
+                PROFILE_SCOPE("insert");
+                grid.reserve(edgelist.size());
+                for (unsigned long i = 0; i < edgelist.size(); i++) {
+                    long a = findVertex(edgelist[i].src), b = findVertex(edgelist[i].dst);
+                    if (a == -1) {
+                        a = vertices.size();
+                        stars.push_back(&registerVertex(arena->vertices.create(edgelist[i].src)));
+                    }
+                    if (b == -1) {
+                        b = vertices.size();
+                        stars.push_back(&registerVertex(arena->vertices.create(edgelist[i].dst)));
+                    }
+                    origin[2 * i] = a;
+                    origin[2 * i + 1] = b;
+                    he[2 * i] = arena->halfEdges.allocate();
+                    he[2 * i + 1] = arena->halfEdges.allocate();
+                }
+                parallelFor(0, m, threads, [&](unsigned long h) {
+                    HalfEdge *e = new (he[h]) HalfEdge(vertices[origin[h]], vertices[origin[h ^ 1]]);
+                    e->twin = he[h ^ 1];
+                });
+            }
+            // Sort all half-edges by origin and clockwise order around it
+            vector<unsigned long> order(m);
+            vector<unsigned long> start(vertices.size() + 1, m); // star of vertex v is order[start[v]] ... order[start[v+1]-1]
+            {
+                PROFILE_SCOPE("sort");
+                vector<StarKey> key(m);
+                parallelFor(0, m, threads, [&](unsigned long h) {
+                    order[h] = h;
+                    key[h] = starKey(he[h]);
+                });
+                parallelSort(order, [&](unsigned long p, unsigned long q) {
+                    if (origin[p] != origin[q]) return origin[p] < origin[q];
+                    if (starBefore(key[p], key[q])) return true;
+                    if (starBefore(key[q], key[p])) return false;
+                    return p < q;
+                }, threads);
+                parallelFor(0, m, threads, [&](unsigned long i) {
+                    if (i == 0 || origin[order[i]] != origin[order[i - 1]]) start[origin[order[i]]] = i;
+                });
+            }
+            // Link consecutive half-edges of every star, as done serially
+            vector<unsigned long> next(m);
+            {
+                PROFILE_SCOPE("link");
+                parallelFor(0, vertices.size(), threads, [&](unsigned long v) {
+                    unsigned long s = start[v], e = start[v + 1];
+                    Star &star = *stars[v];
+                    for (unsigned long i = s; i < e; i++) {
+                        unsigned long h = order[i], g = order[(i + 1 == e) ? s : i + 1];
+                        next[h ^ 1] = g;
+                        he[h ^ 1]->next = he[g];
+                        he[g]->prev = he[h ^ 1];
+                        star.insert(star.end(), he[h]);
                     }
+                    vertices[v]->rep = he[order[s]];
+                });
+            }
+            // Label every cycle of the next permutation with its smallest half-edge
+            {
+                PROFILE_SCOPE("face assignment");
+                vector<unsigned long> label(m), jump(next), label2(m), jump2(m);
+                for (unsigned long h = 0; h < m; h++) label[h] = h;
+                vector<char> changed(threads, 1);
+                while (find(changed.begin(), changed.end(), 1) != changed.end()) {
+                    fill(changed.begin(), changed.end(), 0);
+                    parallelChunks(0, m, threads, [&](unsigned t, unsigned long lo, unsigned long hi) {
+                        for (unsigned long h = lo; h < hi; h++) {
+                            label2[h] = min(label[h], label[jump[h]]);
+                            jump2[h] = jump[jump[h]];
+                            if (label2[h] != label[h]) changed[t] = 1;
+                        }
+                    });
+                    label.swap(label2);
+                    jump.swap(jump2);
+                }
+                // number the faces in order of their smallest half-edge
+                vector<unsigned long> faceId(m);
+                for (unsigned long h = 0; h < m; h++) {
+                    if (label[h] != h) continue;
+                    faceId[h] = faces.size();
+                    faces.push_back(arena->faces.create(faces.size(), he[h]));
                 }
+                totalFaces = faces.size();
+                parallelFor(0, m, threads, [&](unsigned long h) {
+                    he[h]->face = faces[faceId[label[h]]];
+                });
             }
             // DCEL complete
         }
 
+    public:
+        map<Vertex *, Star> heMap; /**< Hash Map to store the clockwise ordered HalfEdge objects leaving each vertex */
+        vector<Vertex *> vertices; /**< List of pointer to all available vertices */
+        vector<Face *> faces; /**< List of pointers to all abailable faces */
+
+        /**
+         * @brief Construct a new DCEL object form the input list of edges
+         * 
+         * The DCEL creates its own arena and frees it when destroyed.
+         * 
+         * @param edgelist a LIst of Edge objects which are used to build the DCEL structure
+         */
+        DCEL(vector<Edge> &edgelist): arena(new DCELArena()), ownsArena(true) {
+            build(edgelist);
+        }
+
+        /**
+         * @brief Construct a new DCEL object from the input list of edges in a given arena
+         * 
+         * @param edgelist a List of Edge objects which are used to build the DCEL structure
+         * @param Arena arena to allocate the objects from, they live until the arena is reset
+         */
+        DCEL(vector<Edge> &edgelist, DCELArena &Arena): arena(&Arena), ownsArena(false) {
+            build(edgelist);
+        }
+
+        /**
+         * @brief Construct a new DCEL object from the input list of edges using several threads
+         * 
+         * Builds the same planar graph as DCEL(vector<Edge>&), see build(vector<Edge>&, unsigned).
+         * The DCEL creates its own arena and frees it when destroyed.
+         * 
+         * @param edgelist a List of Edge objects which are used to build the DCEL structure
+         * @param threads number of threads to use, at least 1
+         */
+        DCEL(vector<Edge> &edgelist, unsigned threads): arena(new DCELArena()), ownsArena(true) {
+            build(edgelist, threads);
+        }
+
+        /**
+         * @brief Construct a new DCEL object from the input list of edges using several threads, in a given arena
+         * 
+         * @param edgelist a List of Edge objects which are used to build the DCEL structure
+         * @param threads number of threads to use, at least 1
+         * @param Arena arena to allocate the objects from, they live until the arena is reset
+         */
+        DCEL(vector<Edge> &edgelist, unsigned threads, DCELArena &Arena): arena(&Arena), ownsArena(false) {
+            build(edgelist, threads);
+        }
+
+        /**
+         * @brief Construct a new DCEL object as an explicit copy of another one
+         *
+         * Every Vertex, HalfEdge and Face of source is copied into a new arena owned by this
+         * DCEL with the same links, the same order in vertices, faces and every star, and the
+         * same face ids, so that edits can be applied to the copy while source is left
+         * unchanged. Takes linear time, without comparing any coordinates.
+         *
+         * @param source DCEL to be copied
+         * @param original filled with the half-edge of source every new half-edge is a copy of
+         */
+        DCEL(DCEL &source, unordered_map<const HalfEdge *, HalfEdge *> &original): arena(new DCELArena()), ownsArena(true) {
+            PROFILE_SCOPE("copy");
+            unordered_map<const Vertex *, Vertex *> vertexCopy;
+            unordered_map<const HalfEdge *, HalfEdge *> copy;
+            grid.reserve(source.vertices.size());
+            for (Vertex *v: source.vertices) registerVertex(vertexCopy[v] = arena->vertices.create(v->x, v->y));
+            for (Vertex *v: source.vertices) {
+                Star &star = heMap[vertexCopy[v]];
+                for (HalfEdge *h: source.heMap[v]) {
+                    HalfEdge *c = arena->halfEdges.create(vertexCopy[h->tail], vertexCopy[h->head]);
+                    star.insert(star.end(), c);
+                    copy[h] = c;
+                    original[c] = h;
+                }
+            }
+            for (Face *f: source.faces) faces.push_back(arena->faces.create(f->id, copy[f->rep]));
+            totalFaces = faces.size();
+            for (auto &c: copy) {
+                c.second->next = copy[c.first->next];
+                c.second->prev = copy[c.first->prev];
+                c.second->twin = copy[c.first->twin];
+                c.second->face = c.first->face ? faces[c.first->face->id] : nullptr;
+            }
+            for (Vertex *v: source.vertices) vertexCopy[v]->rep = v->rep ? copy[v->rep] : nullptr;
+            for (Face *f: source.faces) {
+                faces[f->id]->outer = f->outer ? faces[f->outer->id] : nullptr;
+                faces[f->id]->firstHole = f->firstHole ? faces[f->firstHole->id] : nullptr;
+                faces[f->id]->nextHole = f->nextHole ? faces[f->nextHole->id] : nullptr;
+            }
+        }
+
+        DCEL(const DCEL &) = delete;
+        DCEL& operator=(const DCEL &) = delete;
+
         /**
          * @brief Set a new Face object for the given HalfEdge
          * 
@@ -118,7 +688,7 @@ class DCEL {
          * @param he HalfEdge to which new face must be created ans assigned
          */
         void setFace(HalfEdge* (&he)) {
-            Face *f = new Face(totalFaces++, he); // create face
+            Face *f = arena->faces.create(totalFaces++, he); // create face
             faces.push_back(f); // add to list of faces
             he->face = f;
             HalfEdge *temp = he->next;
@@ -126,6 +696,7 @@ class DCEL {
                 temp->face = f;    // assign face
                 temp = temp->next;
             }
+            for (DCELObserver *o: observers) o->faceChanged(f);
         }
 
         /**
@@ -141,24 +712,9 @@ class DCEL {
         /**
          * @brief Add a new Vertex object to the existing DCEL.
          * 
-         * Addition of Vertex is only done if there is no similar/equal vertex existing in DCEL
-         * 
-         * @param v Pointer to Vertex object to be added
-         * @return Vertex* pointer to the added object in the DCEL
-         */
-        Vertex* addVertex(Vertex *v) {
-            Vertex *a = inSet(*v);
-            if (a != nullptr) return a;
-            heMap[v] = vector<HalfEdge *>{};
-            vertices.push_back(v);
-            return v;
-        }
-
-        /**
-         * @brief Add a new Vertex object to the existing DCEL.
-         * 
-         * Overloaded version of addVertex() function which takes a Vertex object instead
-         * of a pointer. This method builds a new Vertex object dynamically to store in DCEL
+         * Addition of Vertex is only done if there is no similar/equal vertex existing in DCEL.
+         * The vertex is copied into the arena of the DCEL, which never takes ownership of a
+         * Vertex allocated by the caller.
          * 
          * @param v Vertex object to be added
          * @return Vertex* pointer to the added object in the DCEL
@@ -166,9 +722,8 @@ class DCEL {
         Vertex* addVertex(Vertex v) {
             Vertex *a = inSet(v);
             if (a != nullptr) return a;
-            a = new Vertex(v);   
-            heMap[a] = vector<HalfEdge *>{};
-            vertices.push_back(a);
+            a = arena->vertices.create(v);
+            registerVertex(a);
             return a;
         }
 
@@ -191,57 +746,327 @@ class DCEL {
          * 
          * This method dynamically creates two new HalfEdge objects representing the input 
          * Edge and sets all their attributes respectly. This method takes care to also create
-         * and assign new Faces (if formed) automatically.
+         * and assign new Faces (if formed) automatically. Each half-edge is inserted into its
+         * star in O(log d), then only the faces the new edge splits or merges are relabelled.
          * 
-         * @param a Vertex endpoint of the edge to be added
-         * @param b Vertex endpoint of the edge to be added
+         * @param a Vertex endpoint of the edge to be added, copied into the DCEL if not present
+         * @param b Vertex endpoint of the edge to be added, copied into the DCEL if not present
          */
-        void addEdge(Vertex *a, Vertex *b) {
-            a = addVertex(a); // adds if not present
-            b = addVertex(b); // adds if not present
-            HalfEdge *ab = new HalfEdge(a, b);
-            HalfEdge *ba = new HalfEdge(b, a);
-            ab->twin = ba;
-            ab->next = ba;
-            ab->prev = ba;
-            ba->twin = ab;
-            ba->next = ab;
-            ba->prev = ab;
-            heMap[a].push_back(ab);
-            heMap[b].push_back(ba);
-            // TODO: insertion can be done in log(n), right?! (set? list gives o(n))
-            sort(heMap[a].begin(), heMap[a].end(), compare);
-            sort(heMap[b].begin(), heMap[b].end(), compare);
-            for (auto i=heMap[a].begin(); i!=heMap[a].end(); i++) {
-                if (*i != ab) continue;
-                auto before = (i+1 == heMap[a].end())?heMap[a].begin():i+1;
-                HalfEdge *BF = *before;
-                HalfEdge *AB = *i;
-                AB->twin->next = BF;
-                AB->prev = BF->prev;
-                AB->prev->next = AB;
-                BF->prev = AB->twin;
-                break;
+        void addEdge(const Vertex &a, const Vertex &b) {
+            Vertex *p = addVertex(a); // adds if not present
+            Vertex *q = addVertex(b); // adds if not present
+            HalfEdge *ab = newEdge(p, q);
+            linkIntoStar(ab);
+            linkIntoStar(ab->twin);
+            relabelFaces({ab, ab->twin});
+            for (DCELObserver *o: observers) o->edgeAdded(ab);
+        }
+
+        /**
+         * @brief Add a batch of new Edges to the existing DCEL data structure
+         * 
+         * Same as calling addEdge() for every edge, except that faces are relabelled once
+         * for the whole batch: the cycles through the new half-edges are walked a constant
+         * number of times whatever the number of edges added to them. Endpoints are merged
+         * with existing vertices as done by the constructor, so building a DCEL from some
+         * edges and adding the others with addEdges() gives the same DCEL as building it
+         * from all the edges at once.
+         * 
+         * @param edgelist a List of Edge objects to be added
+         * @param created if given, filled with the new half-edge from src to dst of every edge
+         */
+        void addEdges(vector<Edge> &edgelist, vector<HalfEdge *> *created = nullptr) {
+            vector<HalfEdge *> added;
+            added.reserve(edgelist.size());
+            for (Edge &edge: edgelist) {
+                Vertex *a = inSet(edge.src);
+                Vertex *b = inSet(edge.dst);
+                if (a == nullptr) registerVertex(a = arena->vertices.create(edge.src));
+                if (b == nullptr) registerVertex(b = arena->vertices.create(edge.dst));
+                HalfEdge *ab = newEdge(a, b);
+                linkIntoStar(ab);
+                linkIntoStar(ab->twin);
+                added.push_back(ab);
+                added.push_back(ab->twin);
             }
-            for (auto i=heMap[b].begin(); i!=heMap[b].end(); i++) {
-                if (*i != ba) continue;
-                auto before = (i+1 == heMap[b].end())?heMap[b].begin():i+1;
-                HalfEdge *BF = *before;
-                HalfEdge *BA = *i;
-                BA->twin->next = BF;
-                BA->prev = BF->prev;
-                BA->prev->next = BA;
-                BF->prev = BA->twin;
-                break;
+            relabelFaces(added);
+            if (created != nullptr)
+                for (unsigned long i = 0; i < added.size(); i += 2) created->push_back(added[i]);
+            for (DCELObserver *o: observers)
+                for (unsigned long i = 0; i < added.size(); i += 2) o->edgeAdded(added[i]);
+        }
+
+        /**
+         * @brief Remove an edge from the DCEL
+         * 
+         * Both half-edges are cut out of their cycles and stars. If they bordered two
+         * different faces, the faces are merged into one; if they bordered the same face,
+         * its cycle splits in two and a new face is created. Only the cycles through the
+         * edge are walked, so this takes O(d + face size). Endpoints are kept, even if
+         * they are left without any edge. The half-edges are given back to the arena.
+         * 
+         * @param h one of the two half-edges of the edge to be removed
+         */
+        void removeEdge(HalfEdge *h) {
+            for (DCELObserver *o: observers) o->edgeRemoved(h);
+            vector<HalfEdge *> seeds;
+            vector<Face *> dropped;
+            unlinkEdge(h, seeds, dropped);
+            seeds.erase(remove_if(seeds.begin(), seeds.end(), [&](HalfEdge *e) {
+                return e == h || e == h->twin;
+            }), seeds.end());
+            relabelFaces(seeds, dropped);
+            freeEdges({h});
+        }
+
+        /**
+         * @brief Remove a vertex and all its edges from the DCEL
+         * 
+         * All the faces around the vertex are merged into one. Takes O(d log d + size of
+         * the faces around the vertex).
+         * 
+         * @param v Vertex to be removed
+         */
+        void removeVertex(Vertex *v) {
+            vector<HalfEdge *> removed(heMap[v].begin(), heMap[v].end());
+            for (DCELObserver *o: observers)
+                for (HalfEdge *h: removed) o->edgeRemoved(h);
+            vector<HalfEdge *> seeds;
+            vector<Face *> dropped;
+            for (HalfEdge *h: removed) unlinkEdge(h, seeds, dropped);
+            seeds.erase(remove_if(seeds.begin(), seeds.end(), [&](HalfEdge *e) {
+                return e->tail == v || e->head == v;
+            }), seeds.end());
+            relabelFaces(seeds, dropped);
+            freeEdges(removed);
+            unregisterVertex(v);
+        }
+
+        /**
+         * @brief Split an edge in two at a new vertex
+         * 
+         * The vertex must lie on the edge, strictly between its endpoints, so that the
+         * clockwise order around both endpoints is unchanged. Half-edge h (a -> b) becomes
+         * a -> m and its twin becomes m -> a, while a new edge m <-> b is created. Both faces
+         * keep their ids and simply gain one half-edge. Takes O(log d).
+         * 
+         * @param h half-edge (a -> b) of the edge to be split
+         * @param p position of the new vertex m
+         * @return Vertex* the new vertex
+         */
+        Vertex* splitEdge(HalfEdge *h, const Vertex &p) {
+            for (DCELObserver *o: observers) o->edgeRemoved(h);
+            HalfEdge *t = h->twin;
+            Vertex *b = const_cast<Vertex *>(h->head);
+            Vertex *m = arena->vertices.create(p.x, p.y);
+            registerVertex(m);
+            HalfEdge *mb = newEdge(m, b), *bm = mb->twin;
+            mb->face = h->face;
+            bm->face = t->face;
+            // bm takes the place of t around b, keeping the clockwise order
+            Star &star = heMap[b];
+            auto i = findInStar(t);
+            star.insert(i, bm);
+            star.erase(i);
+            if (b->rep == t) b->rep = bm;
+            h->head = m;
+            t->tail = m;
+            heMap[m].insert(t);
+            heMap[m].insert(mb);
+            m->rep = t;
+            relink(bm);
+            relink(mb);
+            for (DCELObserver *o: observers) {
+                o->edgeAdded(h);
+                o->edgeAdded(mb);
+                o->faceChanged(h->face);
+                if (t->face != h->face) o->faceChanged(t->face);
             }
-            ab->face = ab->next->next->face;
-            ab->face->rep = ab;
-            setFace(ba);
+            return m;
         }
 
         /**
-         * @brief Print the directional halfedges which surround the face
+         * @brief Contract an edge, merging its head into its tail
+         * 
+         * The edge is removed and every other edge of the head b is reattached to the tail a,
+         * which keeps its position. The caller must make sure that h is the only edge between
+         * a and b and that moving the edges of b to a keeps the graph planar (for example when
+         * the edge is very short). The stars of a and of the neighbours of b are updated and
+         * the faces around a relabelled, so this takes O((d_a + d_b) log d + size of the faces
+         * around a).
          * 
+         * @param h half-edge (a -> b) of the edge to be contracted
+         * @return Vertex* the remaining vertex a
+         */
+        Vertex* contractEdge(HalfEdge *h) {
+            Vertex *a = const_cast<Vertex *>(h->tail), *b = const_cast<Vertex *>(h->head);
+            for (DCELObserver *o: observers)
+                for (HalfEdge *e: heMap[b]) o->edgeRemoved(e); // h->twin and the edges to be moved
+            vector<HalfEdge *> seeds;
+            vector<Face *> dropped;
+            unlinkEdge(h, seeds, dropped);
+            vector<HalfEdge *> moved(heMap[b].begin(), heMap[b].end());
+            for (HalfEdge *e: moved) {
+                eraseFromStar(e->twin); // before its direction changes
+                e->tail = a;
+                e->twin->head = a;
+                heMap[a].insert(e);
+                heMap[const_cast<Vertex *>(e->twin->tail)].insert(e->twin);
+            }
+            heMap[b].clear();
+            for (HalfEdge *e: moved) relink(e->twin);
+            for (HalfEdge *e: heMap[a]) {
+                relink(e);
+                seeds.push_back(e);
+                seeds.push_back(e->twin);
+            }
+            if (a->rep == nullptr && !heMap[a].empty()) a->rep = *heMap[a].begin();
+            seeds.erase(remove_if(seeds.begin(), seeds.end(), [&](HalfEdge *e) {
+                return e == h || e == h->twin;
+            }), seeds.end());
+            relabelFaces(seeds, dropped);
+            for (DCELObserver *o: observers)
+                for (HalfEdge *e: moved) o->edgeAdded(e);
+            freeEdges({h});
+            unregisterVertex(b);
+            return a;
+        }
+
+        /**
+         * @brief Register an object to be notified of the changes made by edit operations
+         * 
+         * The object must be removed with removeObserver() before it is destroyed.
+         * 
+         * @param o DCELObserver to be notified
+         */
+        void addObserver(DCELObserver *o) {
+            observers.push_back(o);
+        }
+
+        /**
+         * @brief Stop notifying an object registered with addObserver()
+         * 
+         * @param o DCELObserver to be removed
+         */
+        void removeObserver(DCELObserver *o) {
+            observers.erase(remove(observers.begin(), observers.end(), o), observers.end());
+        }
+
+        /**
+         * @brief Move all the objects of the DCEL to memory in Hilbert curve order
+         *
+         * Vertices are sorted along the Hilbert curve over their bounding box, and faces along
+         * the curve by the center of the bounding box of their cycle. New Vertex, HalfEdge and
+         * Face objects are then created in that order, the half-edges of each face one after
+         * the other along its cycle, so that walking a face reads contiguous memory and nearby
+         * faces and vertices are stored close together. Vertices and faces are renumbered in
+         * the new order. Geometry and topology are unchanged but every pointer to a Vertex,
+         * HalfEdge or Face of the DCEL becomes invalid. Observers see every edge removed, then
+         * every edge added and every face changed.
+         *
+         * With its own arena, the DCEL moves to a new arena and frees the old one. With a user
+         * supplied arena, the new objects are taken from it and the old ones are given back.
+         *
+         * @param threads number of threads used to sort the vertices and faces, at least 1
+         */
+        void reorder(unsigned threads = 1) {
+            PROFILE_SCOPE("reorder");
+            for (DCELObserver *o: observers)
+                for (Vertex *v: vertices)
+                    for (HalfEdge *h: heMap[v])
+                        if (h < h->twin) o->edgeRemoved(h);
+            vector<unsigned long> vertexOrder = hilbertOrder(vertices.size(), [&](unsigned long i) { return vertices[i]->x; },
+                [&](unsigned long i) { return vertices[i]->y; }, threads);
+            vector<double> cx(faces.size()), cy(faces.size());
+            parallelFor(0, faces.size(), threads, [&](unsigned long i) {
+                const HalfEdge *h = faces[i]->rep;
+                double minX = h->tail->x, maxX = minX, minY = h->tail->y, maxY = minY;
+                do {
+                    minX = min(minX, h->tail->x);
+                    maxX = max(maxX, h->tail->x);
+                    minY = min(minY, h->tail->y);
+                    maxY = max(maxY, h->tail->y);
+                    h = h->next;
+                } while (h != faces[i]->rep);
+                cx[i] = (minX + maxX) / 2;
+                cy[i] = (minY + maxY) / 2;
+            });
+            vector<unsigned long> faceOrder = hilbertOrder(faces.size(), [&](unsigned long i) { return cx[i]; },
+                [&](unsigned long i) { return cy[i]; }, threads);
+            DCELArena *target = ownsArena ? new DCELArena() : arena;
+
+            // copies of the faces and their cycles, the old prev pointer of every half-edge is
+            // then used to find its copy
+            vector<Face *> movedFaces(faces.size());
+            vector<HalfEdge *> edges;
+            for (unsigned long k = 0; k < faceOrder.size(); k++) {
+                Face *f = faces[faceOrder[k]];
+                movedFaces[k] = target->faces.create(k, nullptr);
+                HalfEdge *h = f->rep;
+                do {
+                    HalfEdge *copy = target->halfEdges.create(nullptr, nullptr);
+                    *copy = *h;
+                    copy->face = movedFaces[k];
+                    h->prev = copy;
+                    edges.push_back(copy);
+                    h = h->next;
+                } while (h != f->rep);
+            }
+            vector<Vertex *> moved(vertices.size());
+            for (unsigned long k = 0; k < vertexOrder.size(); k++) {
+                Vertex *v = vertices[vertexOrder[k]];
+                moved[k] = target->vertices.create(v->x, v->y);
+                moved[k]->rep = v->rep ? v->rep->prev : nullptr;
+                for (HalfEdge *h: heMap[v]) h->prev->tail = moved[k];
+            }
+            for (HalfEdge *copy: edges) {
+                copy->next = copy->next->prev;
+                copy->twin = copy->twin->prev;
+                copy->head = copy->twin->tail;
+            }
+            for (HalfEdge *copy: edges) copy->next->prev = copy;
+            // the id of a face is its position in faceOrder, found through any half-edge copy
+            for (unsigned long k = 0; k < faceOrder.size(); k++) {
+                Face *f = faces[faceOrder[k]], *copy = movedFaces[k];
+                copy->rep = f->rep->prev;
+                copy->outer = f->outer ? f->outer->rep->prev->face : nullptr;
+                copy->firstHole = f->firstHole ? f->firstHole->rep->prev->face : nullptr;
+                copy->nextHole = f->nextHole ? f->nextHole->rep->prev->face : nullptr;
+            }
+            map<Vertex *, Star> stars;
+            for (unsigned long k = 0; k < vertexOrder.size(); k++) {
+                Star &star = stars[moved[k]];
+                for (HalfEdge *h: heMap[vertices[vertexOrder[k]]]) star.insert(star.end(), h->prev);
+            }
+
+            // release the old objects, then rebuild the lookup structures
+            if (ownsArena) {
+                delete arena;
+                arena = target;
+            }
+            else {
+                for (Vertex *v: vertices) {
+                    for (HalfEdge *h: heMap[v]) target->halfEdges.destroy(h);
+                    target->vertices.destroy(v);
+                }
+                for (Face *f: faces) target->faces.destroy(f);
+            }
+            heMap.swap(stars);
+            vertices.swap(moved);
+            faces.swap(movedFaces);
+            totalFaces = faces.size();
+            grid = VertexGrid();
+            grid.reserve(vertices.size());
+            for (unsigned long k = 0; k < vertices.size(); k++) grid.insert(*vertices[k], k);
+            for (DCELObserver *o: observers) {
+                for (HalfEdge *h: edges) if (h < h->twin) o->edgeAdded(h);
+                for (Face *f: faces) o->faceChanged(f);
+            }
+        }
+
+        /**
+         * @brief Print the directional halfedges which surround the face
+         *
          * @param f Pointer to face object
          */
         void printBoundaryEdges(Face *f) {
@@ -256,22 +1081,14 @@ class DCEL {
         /**
          * @brief Destroy the DCEL object
          * 
-         * This function deletes the DCEL data structure and all the 
-         * dynamically allocated objects present in this structure.
+         * This function deletes the DCEL data structure. If the DCEL owns its arena, all the 
+         * Vertex, HalfEdge and Face objects are released at once, one block at a time, instead
+         * of being deleted one by one. Objects allocated from a user supplied arena are left
+         * untouched and are released by DCELArena::reset().
          * 
          */
         ~DCEL() { // free allocated memory
-            for (auto &x : heMap) {
-                Vertex *v = x.first;
-                vector<HalfEdge *> y = x.second;
-                for (HalfEdge *he : y) {
-                    delete he;
-                }
-                delete v;
-            }
-            for (auto &f: faces) {
-                delete f;
-            }
+            if (ownsArena) delete arena;
         }
 };
 
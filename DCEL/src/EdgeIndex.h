@@ -0,0 +1,326 @@
+/**
+ * @file EdgeIndex.h
+ * @brief This file contains a uniform grid over the edges of a DCEL for window and nearest edge queries
+ *
+ * Finding the edges crossing a box or closest to a point would otherwise need a scan of
+ * every half-edge. EdgeIndex buckets the edges into the cells of a grid sized for the DCEL
+ * when it is built, and keeps the buckets in sync with the edits of the DCEL.
+ */
+
+#ifndef __EDGEINDEX_H__
+#define __EDGEINDEX_H__
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "Geometry.h"
+#include "DCEL.h"
+#include "Parallel.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @brief Axis aligned box used as query window
+ *
+ */
+struct Box {
+    double minX, minY, maxX, maxY;
+};
+
+/**
+ * @class EdgeIndex
+ * @brief Uniform grid over the edges of a DCEL
+ *
+ * The grid covers the bounding box of the vertices when the index is built, with about one
+ * cell per edge. Each edge is stored in every cell its bounding box overlaps. Cells on the
+ * border of the grid extend to infinity, so edges added later outside the box are still
+ * found, only less efficiently. Every edge is stored through one of its half-edges, which
+ * is the one returned by the queries.
+ *
+ * The index is an observer of the DCEL: edges added, removed or moved by edits are put into
+ * or taken out of their cells right away. Queries do not modify the index and can run
+ * concurrently, which the batch queries do, but not concurrently with edits.
+ */
+class EdgeIndex: public DCELObserver {
+    private:
+        DCEL &dcel; /**< DCEL whose edges are indexed */
+        double x0, y0; /**< lower left corner of the grid */
+        double side; /**< side of a cell */
+        long cols, rows; /**< number of cells along x and y */
+        vector<vector<HalfEdge *>> cells; /**< edges overlapping each cell, cell (i, j) is cells[j * cols + i] */
+        unsigned long count; /**< number of edges in the index */
+
+        /// Column of the cell containing the given x coordinate, clamped to the grid
+        long column(double x) const {
+            double c = floor((x - x0) / side);
+            return (c < 0) ? 0 : (c >= cols) ? cols - 1 : (long)c;
+        }
+
+        /// Row of the cell containing the given y coordinate, clamped to the grid
+        long row(double y) const {
+            double r = floor((y - y0) / side);
+            return (r < 0) ? 0 : (r >= rows) ? rows - 1 : (long)r;
+        }
+
+        /// Bounding box of an edge
+        static Box bounds(const HalfEdge *h) {
+            return Box{min(h->tail->x, h->head->x), min(h->tail->y, h->head->y),
+                max(h->tail->x, h->head->x), max(h->tail->y, h->head->y)};
+        }
+
+        /**
+         * @brief Call a function for every cell overlapping a box
+         *
+         * @tparam F callable taking a column, a row and the edges of that cell
+         * @param b box whose cells are visited
+         * @param f function called once for every cell
+         */
+        template <class F>
+        void forCells(const Box &b, F f) const {
+            long i1 = column(b.maxX), j1 = row(b.maxY);
+            for (long j = row(b.minY); j <= j1; j++)
+                for (long i = column(b.minX); i <= i1; i++) f(i, j, cells[j * cols + i]);
+        }
+
+        /**
+         * @brief Test whether an edge intersects a box
+         *
+         * The edge is clipped against the four sides of the box (Liang-Barsky).
+         *
+         * @param h half-edge of the edge
+         * @param b closed box
+         * @return true if some point of the edge lies in the box
+         */
+        static bool crosses(const HalfEdge *h, const Box &b) {
+            double px = h->tail->x, py = h->tail->y, dx = h->head->x - px, dy = h->head->y - py;
+            double t0 = 0, t1 = 1;
+            double p[4] = {-dx, dx, -dy, dy}, q[4] = {px - b.minX, b.maxX - px, py - b.minY, b.maxY - py};
+            for (int k = 0; k < 4; k++) {
+                if (p[k] == 0) {
+                    if (q[k] < 0) return false;
+                    continue;
+                }
+                double t = q[k] / p[k];
+                if (p[k] < 0) t0 = max(t0, t);
+                else t1 = min(t1, t);
+                if (t0 > t1) return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Squared distance from a point to an edge
+         *
+         * @param h half-edge of the edge
+         * @param x x coordinate of the point
+         * @param y y coordinate of the point
+         * @return double squared euclidean distance to the closest point of the edge
+         */
+        static double distance2(const HalfEdge *h, double x, double y) {
+            double px = h->tail->x, py = h->tail->y, dx = h->head->x - px, dy = h->head->y - py;
+            double l = dx * dx + dy * dy;
+            double t = (l == 0) ? 0 : ((x - px) * dx + (y - py) * dy) / l;
+            t = max(0.0, min(1.0, t));
+            double ex = px + t * dx - x, ey = py + t * dy - y;
+            return ex * ex + ey * ey;
+        }
+
+        /**
+         * @brief Put an edge into the cells overlapping its bounding box
+         *
+         * @param h half-edge stored for the edge
+         */
+        void insert(HalfEdge *h) {
+            Box b = bounds(h);
+            long i1 = column(b.maxX), j1 = row(b.maxY);
+            for (long j = row(b.minY); j <= j1; j++)
+                for (long i = column(b.minX); i <= i1; i++) cells[j * cols + i].push_back(h);
+            count++;
+        }
+
+    public:
+        /**
+         * @brief Build the index over all the edges of a DCEL
+         *
+         * The cell side is chosen so that the grid has about as many cells as the DCEL has
+         * edges. The DCEL must outlive the index.
+         *
+         * @param d DCEL whose edges are indexed
+         */
+        EdgeIndex(DCEL &d): dcel(d), count(0) {
+            PROFILE_SCOPE("edge index");
+            vector<HalfEdge *> edges;
+            x0 = y0 = 0;
+            double x1 = 0, y1 = 0;
+            if (!dcel.vertices.empty()) {
+                x0 = x1 = dcel.vertices[0]->x;
+                y0 = y1 = dcel.vertices[0]->y;
+            }
+            for (Vertex *v: dcel.vertices) {
+                x0 = min(x0, v->x);
+                y0 = min(y0, v->y);
+                x1 = max(x1, v->x);
+                y1 = max(y1, v->y);
+                for (HalfEdge *h: dcel.heMap[v]) if (h < h->twin) edges.push_back(h);
+            }
+            double w = max(x1 - x0, y1 - y0);
+            side = (w > 0 && !edges.empty()) ? max(sqrt((x1 - x0) * (y1 - y0) / edges.size()), w / edges.size()) : 1;
+            cols = (long)((x1 - x0) / side) + 1;
+            rows = (long)((y1 - y0) / side) + 1;
+            cells.resize(cols * rows);
+            for (HalfEdge *h: edges) insert(h);
+            dcel.addObserver(this);
+        }
+
+        EdgeIndex(const EdgeIndex &) = delete;
+        EdgeIndex& operator=(const EdgeIndex &) = delete;
+
+        /**
+         * @brief Destroy the index and stop observing the DCEL
+         *
+         */
+        ~EdgeIndex() {
+            dcel.removeObserver(this);
+        }
+
+        /// Number of edges in the index
+        unsigned long size() const { return count; }
+
+        /**
+         * @brief Find the edges intersecting a box
+         *
+         * An edge overlapping several cells of the window is only reported by the cell
+         * containing the lower left corner of the overlap of its bounding box with the
+         * window, so every edge is reported once without marking visited edges.
+         *
+         * @param b closed query box
+         * @return vector<HalfEdge *> one half-edge of every edge having a point in the box
+         */
+        vector<HalfEdge *> window(const Box &b) const {
+            vector<HalfEdge *> found;
+            forCells(b, [&](long i, long j, const vector<HalfEdge *> &cell) {
+                for (HalfEdge *h: cell) {
+                    Box e = bounds(h);
+                    if (e.minX > b.maxX || e.maxX < b.minX || e.minY > b.maxY || e.maxY < b.minY) continue;
+                    if (column(max(e.minX, b.minX)) != i || row(max(e.minY, b.minY)) != j) continue;
+                    if (crosses(h, b)) found.push_back(h);
+                }
+            });
+            return found;
+        }
+
+        /**
+         * @brief Find the edges intersecting each box of a batch using several threads
+         *
+         * @param boxes query boxes
+         * @param threads number of threads to use, at least 1
+         * @return vector<vector<HalfEdge *>> result of window() for every box
+         */
+        vector<vector<HalfEdge *>> window(const vector<Box> &boxes, unsigned threads) const {
+            vector<vector<HalfEdge *>> found(boxes.size());
+            parallelFor(0, boxes.size(), threads, [&](unsigned long i) { found[i] = window(boxes[i]); });
+            return found;
+        }
+
+        /**
+         * @brief Find the k edges closest to a point
+         *
+         * Cells are visited in square rings around the cell of the point, until the k-th
+         * closest edge found is closer than any cell not visited yet.
+         *
+         * @param p query point
+         * @param k number of edges wanted
+         * @return vector<HalfEdge *> one half-edge of each of the k closest edges (fewer if the
+         * DCEL has less than k edges), by increasing distance
+         */
+        vector<HalfEdge *> nearest(const Vertex &p, unsigned long k) const {
+            vector<pair<double, HalfEdge *>> best; // heap of the k closest so far, farthest on top
+            long ci = column(p.x), cj = row(p.y);
+            for (long r = 0; k > 0; r++) {
+                long i0 = ci - r, i1 = ci + r, j0 = cj - r, j1 = cj + r;
+                if (i0 < 0 && j0 < 0 && i1 >= cols && j1 >= rows) break; // the whole grid was visited
+                for (long j = max(j0, 0L); j <= min(j1, rows - 1); j++) {
+                    for (long i = max(i0, 0L); i <= min(i1, cols - 1); i++) {
+                        if (i != i0 && i != i1 && j != j0 && j != j1) continue; // inside the ring
+                        for (HalfEdge *h: cells[j * cols + i]) {
+                            double d = distance2(h, p.x, p.y);
+                            if (best.size() == k && d >= best.front().first) continue;
+                            // an edge in several cells is only kept once
+                            bool seen = false;
+                            for (auto &b: best) seen |= (b.second == h);
+                            if (seen) continue;
+                            if (best.size() == k) {
+                                pop_heap(best.begin(), best.end());
+                                best.pop_back();
+                            }
+                            best.emplace_back(d, h);
+                            push_heap(best.begin(), best.end());
+                        }
+                    }
+                }
+                if (best.size() < k) continue;
+                // distance to the closest cell outside the visited square, border cells being infinite
+                double reach = numeric_limits<double>::infinity();
+                if (i0 > 0) reach = min(reach, p.x - (x0 + i0 * side));
+                if (i1 < cols - 1) reach = min(reach, x0 + (i1 + 1) * side - p.x);
+                if (j0 > 0) reach = min(reach, p.y - (y0 + j0 * side));
+                if (j1 < rows - 1) reach = min(reach, y0 + (j1 + 1) * side - p.y);
+                if (reach == numeric_limits<double>::infinity() || best.front().first <= reach * reach) break;
+            }
+            sort_heap(best.begin(), best.end());
+            vector<HalfEdge *> found;
+            for (auto &b: best) found.push_back(b.second);
+            return found;
+        }
+
+        /**
+         * @brief Find the k closest edges to each point of a batch using several threads
+         *
+         * @param points query points
+         * @param k number of edges wanted for every point
+         * @param threads number of threads to use, at least 1
+         * @return vector<vector<HalfEdge *>> result of nearest() for every point
+         */
+        vector<vector<HalfEdge *>> nearest(const vector<Vertex> &points, unsigned long k, unsigned threads) const {
+            vector<vector<HalfEdge *>> found(points.size());
+            parallelFor(0, points.size(), threads, [&](unsigned long i) { found[i] = nearest(points[i], k); });
+            return found;
+        }
+
+        /**
+         * @brief Put an edge added or moved by an edit into its cells
+         *
+         * @param h one of the two half-edges of the edge
+         */
+        void edgeAdded(HalfEdge *h) override {
+            insert(min(h, h->twin));
+        }
+
+        /**
+         * @brief Take an edge about to be removed or moved out of its cells
+         *
+         * @param h one of the two half-edges of the edge
+         */
+        void edgeRemoved(HalfEdge *h) override {
+            h = min(h, h->twin);
+            Box b = bounds(h);
+            long i1 = column(b.maxX), j1 = row(b.maxY);
+            bool erased = false;
+            for (long j = row(b.minY); j <= j1; j++) {
+                for (long i = column(b.minX); i <= i1; i++) {
+                    vector<HalfEdge *> &cell = cells[j * cols + i];
+                    auto found = find(cell.begin(), cell.end(), h);
+                    if (found == cell.end()) continue;
+                    cell.erase(found);
+                    erased = true;
+                }
+            }
+            if (erased) count--;
+        }
+};
+
+#endif
@@ -0,0 +1,222 @@
+/**
+ * @file FaceMetrics.h
+ * @brief This file contains a cache of geometric measures of the faces of a DCEL
+ *
+ * Area, perimeter, bounding box, centroid and size of a face all need a walk around its
+ * boundary. FaceMetricsCache computes them on first use, or for all faces at once with
+ * several threads, keeps them and recomputes only the faces changed by edits of the DCEL.
+ */
+
+#ifndef __FACEMETRICS_H__
+#define __FACEMETRICS_H__
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "Geometry.h"
+#include "DCEL.h"
+#include "Parallel.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @brief Geometric measures of a face
+ *
+ */
+struct FaceMetrics {
+    double area; /**< signed area of the boundary cycle, positive for bounded faces */
+    double perimeter; /**< total length of the boundary half-edges */
+    double minX, minY, maxX, maxY; /**< bounding box of the boundary */
+    double cx, cy; /**< centroid of the region enclosed by the cycle, mean of the boundary vertices if its area is 0 */
+    unsigned long vertexCount; /**< number of half-edges on the boundary, a vertex visited twice is counted twice */
+
+    /// true if the face is bounded, which is when its cycle goes counter-clockwise
+    bool bounded() const { return area > 0; }
+};
+
+/**
+ * @brief Walk around a face and compute its measures
+ *
+ * Coordinates are taken relative to the first vertex of the cycle, which keeps the area
+ * accurate for small faces far from the origin such as city blocks given in degrees.
+ * Faces lie to the left of their half-edges, hence the cycle of a bounded face goes
+ * counter-clockwise and has a positive area. The outer cycle of a connected component
+ * goes clockwise and has a negative area, or 0 if the component has no bounded face.
+ *
+ * @param f Face to be measured
+ * @return FaceMetrics measures of the face
+ */
+FaceMetrics measureFace(const Face *f) {
+    const HalfEdge *h = f->rep;
+    double x0 = h->tail->x, y0 = h->tail->y;
+    FaceMetrics m = {0, 0, x0, y0, x0, y0, 0, 0, 0};
+    double a2 = 0, sx = 0, sy = 0, mx = 0, my = 0;
+    do {
+        double px = h->tail->x - x0, py = h->tail->y - y0;
+        double qx = h->head->x - x0, qy = h->head->y - y0;
+        double c = px * qy - qx * py;
+        a2 += c;
+        sx += (px + qx) * c;
+        sy += (py + qy) * c;
+        mx += px;
+        my += py;
+        m.perimeter += hypot(qx - px, qy - py);
+        m.minX = min(m.minX, h->tail->x);
+        m.minY = min(m.minY, h->tail->y);
+        m.maxX = max(m.maxX, h->tail->x);
+        m.maxY = max(m.maxY, h->tail->y);
+        m.vertexCount++;
+        h = h->next;
+    } while (h != f->rep);
+    m.area = a2 / 2;
+    if (a2 != 0) {
+        m.cx = x0 + sx / (3 * a2);
+        m.cy = y0 + sy / (3 * a2);
+    }
+    else {
+        m.cx = x0 + mx / m.vertexCount;
+        m.cy = y0 + my / m.vertexCount;
+    }
+    return m;
+}
+
+/**
+ * @class FaceMetricsCache
+ * @brief Measures of the faces of a DCEL, computed when needed and kept in sync with its edits
+ *
+ * Measures are stored by face id. The cache registers itself as an observer of the DCEL:
+ * a face whose cycle is changed by addEdge(), removeEdge(), splitEdge() or any other edit
+ * is marked stale, and the entry of a removed face is replaced by the one of the face
+ * taking its id, so the measures of untouched faces are never recomputed. get() is not
+ * thread safe since it may fill the cache; computeAll() fills it with several threads.
+ */
+class FaceMetricsCache: public DCELObserver {
+    private:
+        DCEL &dcel; /**< DCEL whose faces are measured */
+        vector<FaceMetrics> metrics; /**< measures of each face, by face id */
+        vector<char> valid; /**< valid[i] is 1 if metrics[i] is up to date */
+
+    public:
+        /**
+         * @brief Construct an empty cache over the faces of a DCEL
+         *
+         * No face is measured until it is asked for. The DCEL must outlive the cache.
+         *
+         * @param d DCEL whose faces are measured
+         */
+        FaceMetricsCache(DCEL &d): dcel(d), metrics(d.faces.size()), valid(d.faces.size(), 0) {
+            dcel.addObserver(this);
+        }
+
+        FaceMetricsCache(const FaceMetricsCache &) = delete;
+        FaceMetricsCache& operator=(const FaceMetricsCache &) = delete;
+
+        /**
+         * @brief Destroy the cache and stop observing the DCEL
+         *
+         */
+        ~FaceMetricsCache() {
+            dcel.removeObserver(this);
+        }
+
+        /**
+         * @brief Measures of a face, computed now if they are not cached
+         *
+         * @param f Face of the DCEL
+         * @return const FaceMetrics& measures of the face, valid until the next edit of the DCEL
+         */
+        const FaceMetrics& get(const Face *f) {
+            if (!valid[f->id]) {
+                metrics[f->id] = measureFace(f);
+                valid[f->id] = 1;
+            }
+            return metrics[f->id];
+        }
+
+        /**
+         * @brief Compute the measures of every face which is not cached
+         *
+         * Only the stale faces are walked, split among the threads, so calling this after
+         * a few edits takes time proportional to the size of the changed faces.
+         *
+         * @param threads number of threads to use, at least 1
+         */
+        void computeAll(unsigned threads = 1) {
+            PROFILE_SCOPE("face metrics");
+            vector<unsigned long> stale;
+            for (unsigned long i = 0; i < valid.size(); i++) if (!valid[i]) stale.push_back(i);
+            parallelFor(0, stale.size(), threads, [&](unsigned long k) {
+                metrics[stale[k]] = measureFace(dcel.faces[stale[k]]);
+                valid[stale[k]] = 1;
+            });
+        }
+
+        /**
+         * @brief The unbounded face of the DCEL
+         *
+         * The face with the smallest signed area, which for a connected DCEL is its only
+         * clockwise cycle and otherwise the outer face of the component enclosing the most
+         * area. Computes the measures of all the stale faces.
+         *
+         * @return Face* the unbounded face, nullptr if the DCEL has no face
+         */
+        Face* unboundedFace() {
+            computeAll();
+            Face *outer = nullptr;
+            for (Face *f: dcel.faces)
+                if (outer == nullptr || metrics[f->id].area < metrics[outer->id].area) outer = f;
+            return outer;
+        }
+
+        /**
+         * @brief Area of a bounded face minus the area of its holes
+         *
+         * Holes are the clockwise cycles linked to f by findHoles(), which must have been
+         * run since the last edit. Their signed area is negative, so it is simply added.
+         *
+         * @param f bounded Face of the DCEL
+         * @return double area of the region covered by f
+         */
+        double areaWithHoles(const Face *f) {
+            double area = get(f).area;
+            for (const Face *h = f->firstHole; h != nullptr; h = h->nextHole) area += get(h).area;
+            return area;
+        }
+
+        /// true if the measures of the face are cached and up to date
+        bool cached(const Face *f) const { return valid[f->id]; }
+
+        /**
+         * @brief Mark a created or changed face as stale
+         *
+         * @param f Face whose cycle changed
+         */
+        void faceChanged(Face *f) override {
+            if (valid.size() <= (unsigned long)f->id) {
+                metrics.resize(f->id + 1);
+                valid.resize(f->id + 1, 0);
+            }
+            valid[f->id] = 0;
+        }
+
+        /**
+         * @brief Move the entry of the last face into the place of a removed face
+         *
+         * @param id id of the removed face
+         * @param last previous id of the face which now has id id
+         */
+        void faceRemoved(unsigned long id, unsigned long last) override {
+            if (valid.size() <= last) {
+                metrics.resize(last + 1);
+                valid.resize(last + 1, 0);
+            }
+            metrics[id] = metrics[last];
+            valid[id] = valid[last];
+            metrics.resize(dcel.faces.size());
+            valid.resize(dcel.faces.size(), 0);
+        }
+};
+
+#endif
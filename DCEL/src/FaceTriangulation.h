@@ -0,0 +1,510 @@
+/**
+ * @file FaceTriangulation.h
+ * @brief This file contains the triangulation of all the bounded faces of a DCEL
+ *
+ * Each bounded face is triangulated by planeSweepTriangulate() of the Triangulation module,
+ * or by earClippingTriangulate() when the plane sweep fails or the face has holes, with
+ * several threads working on different faces. The triangles of all faces are stored in one
+ * indexed mesh whose corners are the positions of vertices in DCEL::vertices.
+ */
+
+#ifndef __FACETRIANGULATION_H__
+#define __FACETRIANGULATION_H__
+
+#include <map>
+#include <deque>
+#include <set>
+#include <list>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Geometry.h"
+#include "DCEL.h"
+#include "FaceMetrics.h"
+#include "GraphExport.h"
+#include "Intersections.h"
+#include "Parallel.h"
+#include "Predicates.h"
+#include "Profiler.h"
+
+// The Triangulation module has its own Geometry.h and Tools.h, with classes, functions and
+// include guards named like the ones of this module. Its headers are read inside namespace
+// triangulation with these two guards lifted. Every header they include from outside the
+// module is already included above, so only its own code lands in the namespace.
+#pragma push_macro("__GEOMETRY_H__")
+#pragma push_macro("__TOOLS_H__")
+#undef __GEOMETRY_H__
+#undef __TOOLS_H__
+namespace triangulation {
+#include "../../Triangulation/src/planeSweepTriangulation.h"
+#include "../../Triangulation/src/earClippingTriangulation.h"
+}
+#pragma pop_macro("__TOOLS_H__")
+#pragma pop_macro("__GEOMETRY_H__")
+
+using namespace std;
+
+/**
+ * @brief Triangles covering the bounded faces of a DCEL
+ *
+ * Triangle t has corners corners[3t], corners[3t+1] and corners[3t+2], given counter-clockwise
+ * as positions in DCEL::vertices. The triangles of face f are offsets[f] ... offsets[f+1]-1,
+ * f being the id of the face.
+ */
+struct TriangleMesh {
+    vector<uint32_t> corners; /**< three vertex ids per triangle */
+    vector<uint32_t> offsets; /**< first triangle of each face, one more entry than faces */
+    vector<uint32_t> failed; /**< bounded faces left without triangles, in increasing order */
+
+    /// Number of triangles
+    unsigned long size() const { return corners.size() / 3; }
+
+    /// Number of triangles of the face with the given id
+    unsigned long faceSize(unsigned long f) const { return offsets[f + 1] - offsets[f]; }
+};
+
+/**
+ * @brief Buffers reused by one thread for all the faces it triangulates
+ *
+ */
+struct FaceTriangulationScratch {
+    vector<const HalfEdge *> boundary; /**< boundary of the current face, clockwise, without its dead ends */
+    vector<const HalfEdge *> path; /**< part of the boundary walked so far, without the closed sub-rings */
+    unordered_map<const Vertex *, uint32_t> position; /**< position in path of the tail of each of its half-edges */
+    vector<const Vertex *> cut; /**< DCEL vertices of the simple sub-rings of the boundary and holes of the current face */
+    vector<pair<uint32_t, uint32_t>> rings; /**< first and one past the last position in cut of each sub-ring */
+    unordered_set<const Vertex *> joined; /**< vertices of the ring being joined with its holes */
+    vector<triangulation::Vertex> ring; /**< current ring, clockwise, in local coordinates */
+    vector<const Vertex *> vertices; /**< DCEL vertices of all the rings of the current face with their holes joined, one after another */
+    vector<pair<triangulation::Vertex, uint32_t>> lookup; /**< points of ring sorted by coordinates, with their position in ring */
+    vector<uint32_t> triangles; /**< positions in vertices of the corners of the triangles of the current face */
+    vector<uint32_t> corners; /**< vertex ids of the corners of all the triangles found by the thread */
+    vector<uint32_t> failed; /**< bounded faces the thread could not triangulate */
+};
+
+/**
+ * @brief Keep the triangles found for a ring if they cover it exactly
+ *
+ * Corners of the triangles are copies of ring points and are found back in s.lookup by
+ * exact comparison of their coordinates. The triangles are turned counter-clockwise and
+ * appended to s.triangles, and removed again if they are not n-2 or if overlapping or
+ * missing triangles change the covered area.
+ *
+ * @param triangles triangles given by the Triangulation module for the ring
+ * @param base position in s.vertices of the first vertex of the ring
+ * @param area2 twice the area of the ring
+ * @param s buffers of the calling thread
+ * @return true if the triangles were kept
+ */
+bool keepTriangles(const vector<triangulation::Triangle> &triangles, unsigned long base, double area2, FaceTriangulationScratch &s) {
+    unsigned long n = s.vertices.size() - base, mark = s.triangles.size();
+    if (triangles.size() != n - 2) return false;
+    auto byPoint = [](const pair<triangulation::Vertex, uint32_t> &a, const pair<triangulation::Vertex, uint32_t> &b) {
+        return a.first < b.first;
+    };
+    double covered2 = 0;
+    for (const triangulation::Triangle &t: triangles) {
+        uint32_t c[3];
+        for (int k = 0; k < 3; k++) {
+            auto it = lower_bound(s.lookup.begin(), s.lookup.end(), make_pair(t.v[k], (uint32_t)0), byPoint);
+            if (it == s.lookup.end() || t.v[k] < it->first) {
+                s.triangles.resize(mark);
+                return false;
+            }
+            c[k] = base + it->second;
+        }
+        const Vertex *a = s.vertices[c[0]], *b = s.vertices[c[1]], *d = s.vertices[c[2]];
+        double cross = (b->x - a->x) * (d->y - a->y) - (d->x - a->x) * (b->y - a->y);
+        if (cross < 0) swap(c[1], c[2]);
+        covered2 += abs(cross);
+        s.triangles.insert(s.triangles.end(), c, c + 3);
+    }
+    if (abs(covered2 - area2) <= 1e-6 * area2) return true;
+    s.triangles.resize(mark);
+    return false;
+}
+
+/**
+ * @brief Triangulate a clockwise ring with planeSweepTriangulate() or earClippingTriangulate()
+ *
+ * The ring is made of s.vertices[base] ... s.vertices.back(). The Triangulation module uses
+ * float coordinates and takes points closer than 0.001 as equal, so the ring is first moved
+ * to a local frame where its bounding box spans 10^4 units. A simple ring goes to the plane
+ * sweep and, if its triangles are rejected by keepTriangles(), to ear clipping. A ring going
+ * through a vertex twice, as a ring with its holes joined by bridges, only goes to ear
+ * clipping, since the plane sweep takes simple polygons. The ring is rejected if it runs
+ * counter-clockwise, if two of its vertices are equal in the local frame, or if neither
+ * algorithm covers it.
+ *
+ * @param base position in s.vertices of the first vertex of the ring
+ * @param s buffers of the calling thread, the triangles are appended to s.triangles
+ * @return true if the ring was triangulated, with no triangles if it covers no region
+ */
+bool triangulateRing(unsigned long base, FaceTriangulationScratch &s) {
+    s.ring.clear();
+    s.lookup.clear();
+    unsigned long n = s.vertices.size() - base;
+    if (n < 3) return true;
+    double x0 = s.vertices[base]->x, y0 = s.vertices[base]->y;
+    double minX = x0, minY = y0, maxX = x0, maxY = y0, area2 = 0;
+    for (unsigned long i = 0; i < n; i++) {
+        const Vertex *v = s.vertices[base + i], *w = s.vertices[base + (i + 1) % n];
+        minX = min(minX, v->x);
+        minY = min(minY, v->y);
+        maxX = max(maxX, v->x);
+        maxY = max(maxY, v->y);
+        area2 += (w->x - x0) * (v->y - y0) - (v->x - x0) * (w->y - y0); // clockwise area
+    }
+    if (area2 < 0) return false;
+    if (area2 == 0) return true;
+    double scale = 10000 / max(maxX - minX, maxY - minY);
+    for (unsigned long i = 0; i < n; i++) {
+        const Vertex *v = s.vertices[base + i];
+        s.ring.emplace_back((float)((v->x - minX) * scale), (float)((v->y - minY) * scale));
+        s.lookup.emplace_back(s.ring[i], i);
+    }
+    sort(s.lookup.begin(), s.lookup.end(), [](const pair<triangulation::Vertex, uint32_t> &a, const pair<triangulation::Vertex, uint32_t> &b) {
+        return a.first < b.first;
+    });
+    bool simple = true;
+    for (unsigned long i = 1; i < n; i++) {
+        if (s.lookup[i - 1].first < s.lookup[i].first) continue;
+        if (s.vertices[base + s.lookup[i - 1].second] != s.vertices[base + s.lookup[i].second]) return false; // distinct vertices rounded to the same point
+        simple = false;
+    }
+    if (simple && keepTriangles(triangulation::planeSweepTriangulate(s.ring), base, area2, s)) return true;
+    return keepTriangles(triangulation::earClippingTriangulate(s.ring), base, area2, s);
+}
+
+/**
+ * @brief Cut a cycle of half-edges into simple clockwise sub-rings
+ *
+ * The cycle is walked backwards, which gives the clockwise order expected by the
+ * Triangulation module for a counter-clockwise boundary, dropping the edges of dead ends
+ * since they do not change the region it covers. A cycle going through a vertex twice,
+ * where two parts of the face touch, is cut there into simple sub-rings: whenever the walk
+ * comes back to a vertex of the path walked so far, the closed part is taken out of the
+ * path. A sub-ring running counter-clockwise is a hole, like the sub-rings of a clockwise
+ * hole cycle.
+ *
+ * @param rep any half-edge of the cycle
+ * @param s buffers of the calling thread, the sub-rings are appended to s.cut and s.rings
+ */
+void cutRings(const HalfEdge *rep, FaceTriangulationScratch &s) {
+    s.boundary.clear();
+    s.path.clear();
+    s.position.clear();
+    const HalfEdge *h = rep;
+    do {
+        if (!s.boundary.empty() && s.boundary.back() == h->twin) s.boundary.pop_back(); // back from a dead end
+        else s.boundary.push_back(h);
+        h = h->prev;
+    } while (h != rep);
+    unsigned long first = 0, last = s.boundary.size(); // the walk may have started inside a dead end
+    while (last - first > 2 && s.boundary[first] == s.boundary[last - 1]->twin) {
+        first++;
+        last--;
+    }
+    // each half-edge goes from the tail of the next one to its own tail, so when the tail of
+    // e is the tail of path[j], path[j+1] ... path.back() and e form a closed sub-ring
+    for (unsigned long i = first; i < last; i++) {
+        const HalfEdge *e = s.boundary[i];
+        auto seen = s.position.find(e->tail);
+        if (seen == s.position.end()) {
+            s.position[e->tail] = s.path.size();
+            s.path.push_back(e);
+            continue;
+        }
+        uint32_t base = s.cut.size();
+        for (unsigned long j = seen->second + 1; j < s.path.size(); j++) {
+            s.cut.push_back(s.path[j]->tail);
+            s.position.erase(s.path[j]->tail);
+        }
+        s.cut.push_back(e->tail);
+        s.path.resize(seen->second + 1);
+        s.rings.emplace_back(base, s.cut.size());
+    }
+    if (s.path.empty()) return;
+    uint32_t base = s.cut.size();
+    for (const HalfEdge *e: s.path) s.cut.push_back(e->tail);
+    s.rings.emplace_back(base, s.cut.size());
+}
+
+/**
+ * @brief Twice the signed area of a sub-ring, positive when it runs clockwise
+ *
+ * @param r first and one past the last position in s.cut of the sub-ring
+ * @param s buffers of the calling thread
+ * @return double twice the area, negative for a hole
+ */
+double ringArea2(const pair<uint32_t, uint32_t> &r, const FaceTriangulationScratch &s) {
+    double x0 = s.cut[r.first]->x, y0 = s.cut[r.first]->y, area2 = 0;
+    for (uint32_t i = r.first; i < r.second; i++) {
+        const Vertex *v = s.cut[i], *w = s.cut[i + 1 < r.second ? i + 1 : r.first];
+        area2 += (w->x - x0) * (v->y - y0) - (v->x - x0) * (w->y - y0);
+    }
+    return area2;
+}
+
+/**
+ * @brief Whether a point lies inside a sub-ring, by the parity of the edges crossed by a ray
+ *
+ * @param r first and one past the last position in s.cut of the sub-ring
+ * @param x x coordinate of the point
+ * @param y y coordinate of the point
+ * @param s buffers of the calling thread
+ * @return true if a horizontal ray from the point crosses the sub-ring an odd number of times
+ */
+bool ringContains(const pair<uint32_t, uint32_t> &r, double x, double y, const FaceTriangulationScratch &s) {
+    bool inside = false;
+    for (uint32_t i = r.first; i < r.second; i++) {
+        const Vertex *v = s.cut[i], *w = s.cut[i + 1 < r.second ? i + 1 : r.first];
+        if ((v->y > y) == (w->y > y)) continue;
+        if (v->x + (y - v->y) / (w->y - v->y) * (w->x - v->x) > x) inside = !inside;
+    }
+    return inside;
+}
+
+/**
+ * @brief Whether the direction from a ring vertex towards a point enters the ring
+ *
+ * The ring runs clockwise, so the region it bounds lies on the right of its edges.
+ *
+ * @param p vertex of the ring
+ * @param before vertex before p in the ring
+ * @param after vertex after p in the ring
+ * @param q point towards which the direction goes
+ * @return true if the direction lies strictly inside the angle of the ring at p
+ */
+bool inCone(const Vertex *p, const Vertex *before, const Vertex *after, const Vertex *q) {
+    auto turn = [](const Vertex *a, const Vertex *b, const Vertex *c) { return orientExact(a->x, a->y, b->x, b->y, c->x, c->y); };
+    if (turn(after, p, before) >= 0) return turn(p, q, after) > 0 && turn(q, p, before) > 0;
+    return !(turn(p, q, before) >= 0 && turn(q, p, after) >= 0);
+}
+
+/**
+ * @brief Whether an edge meets the segment pq elsewhere than at an endpoint of both
+ *
+ * @param p first endpoint of the segment
+ * @param q second endpoint of the segment
+ * @param u first endpoint of the edge
+ * @param v second endpoint of the edge
+ * @return true if the edge crosses the segment or has an endpoint inside it
+ */
+bool blocks(const Vertex *p, const Vertex *q, const Vertex *u, const Vertex *v) {
+    if (u == p || u == q || v == p || v == q) return false; // the cones at p and q rule out overlaps
+    int ou = orientExact(p->x, p->y, q->x, q->y, u->x, u->y), ov = orientExact(p->x, p->y, q->x, q->y, v->x, v->y);
+    auto inside = [p, q](const Vertex *w) {
+        return (w->x - p->x) * (q->x - p->x) + (w->y - p->y) * (q->y - p->y) > 0 &&
+            (w->x - q->x) * (p->x - q->x) + (w->y - q->y) * (p->y - q->y) > 0;
+    };
+    if ((ou == 0 && inside(u)) || (ov == 0 && inside(v))) return true;
+    if (ou * ov >= 0) return false;
+    int op = orientExact(u->x, u->y, v->x, v->y, p->x, p->y), oq = orientExact(u->x, u->y, v->x, v->y, q->x, q->y);
+    return op * oq < 0;
+}
+
+/**
+ * @brief Join a hole to the ring around it with a bridge edge
+ *
+ * A hole touching the ring at a vertex m is entered at m without a bridge. Otherwise the
+ * bridge goes from the rightmost vertex m of the hole to the closest vertex p of the ring
+ * it can see, that is the first one in the angle of the ring at p, in the angle of the hole
+ * at m and with no edge of the ring or of the holes still to join across it. The ring then
+ * goes from p into the hole, around the hole back to m and over the bridge again to p, so
+ * both go through it twice. Holes which do not touch the ring are joined from right to
+ * left, so the ring always reaches to the right of m.
+ *
+ * @param base position in s.vertices of the first vertex of the ring
+ * @param hole sub-ring in s.cut of the hole
+ * @param others sub-rings in s.cut of the holes still to join, the hole among them
+ * @param s buffers of the calling thread, s.joined is updated with the vertices of the hole
+ * @return true if the hole was joined
+ */
+bool joinHole(unsigned long base, const pair<uint32_t, uint32_t> &hole, const vector<pair<uint32_t, uint32_t>> &others,
+        FaceTriangulationScratch &s) {
+    uint32_t k = hole.second - hole.first, j = hole.first;
+    while (j < hole.second && s.joined.count(s.cut[j]) == 0) j++;
+    if (j == hole.second) {
+        j = hole.first;
+        for (uint32_t i = hole.first + 1; i < hole.second; i++)
+            if (lexLess(s.cut[j]->x, s.cut[j]->y, s.cut[i]->x, s.cut[i]->y)) j = i;
+    }
+    const Vertex *m = s.cut[j];
+    const Vertex *mBefore = s.cut[j > hole.first ? j - 1 : hole.second - 1], *mAfter = s.cut[j + 1 < hole.second ? j + 1 : hole.first];
+    unsigned long n = s.vertices.size() - base;
+    vector<pair<double, unsigned long>> candidates;
+    for (unsigned long i = 0; i < n; i++) {
+        const Vertex *p = s.vertices[base + i];
+        candidates.emplace_back((p->x - m->x) * (p->x - m->x) + (p->y - m->y) * (p->y - m->y), i);
+    }
+    sort(candidates.begin(), candidates.end());
+    for (const pair<double, unsigned long> &c: candidates) {
+        unsigned long i = c.second;
+        const Vertex *p = s.vertices[base + i];
+        const Vertex *before = s.vertices[base + (i + n - 1) % n], *after = s.vertices[base + (i + 1) % n];
+        if (p == m) {
+            if (!inCone(p, before, after, mAfter)) continue;
+        }
+        else {
+            if (!inCone(p, before, after, m) || !inCone(m, mBefore, mAfter, p)) continue;
+            bool seen = true;
+            for (unsigned long e = 0; e < n && seen; e++)
+                seen = !blocks(p, m, s.vertices[base + e], s.vertices[base + (e + 1) % n]);
+            for (const pair<uint32_t, uint32_t> &r: others)
+                for (uint32_t e = r.first; e < r.second && seen; e++)
+                    seen = !blocks(p, m, s.cut[e], s.cut[e + 1 < r.second ? e + 1 : r.first]);
+            if (!seen) continue;
+        }
+        vector<const Vertex *> detour;
+        for (uint32_t e = 1; e <= k; e++) detour.push_back(s.cut[hole.first + (j - hole.first + e) % k]);
+        if (p != m) {
+            detour.insert(detour.begin(), m);
+            detour.push_back(p);
+        }
+        s.vertices.insert(s.vertices.begin() + base + i + 1, detour.begin(), detour.end());
+        s.joined.insert(s.cut.begin() + hole.first, s.cut.begin() + hole.second);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Triangulate one bounded face with its holes
+ *
+ * The boundary of the face and the cycles of its holes are cut into simple sub-rings by
+ * cutRings(). Clockwise sub-rings bound parts of the face, and every counter-clockwise one,
+ * either a hole touching the boundary at a vertex or a hole given by findHoles() (Holes.h),
+ * is joined by joinHole() to the clockwise sub-ring around it, the smallest one containing
+ * the middle of its first edge, first the holes touching it and then the others from
+ * right to left. Each clockwise sub-ring with its holes joined is then
+ * triangulated by triangulateRing(), and the face fails if one of them does or if a hole
+ * cannot be joined.
+ *
+ * @param f bounded Face to triangulate
+ * @param s buffers of the calling thread, the triangles are left in s.triangles
+ * @return true if the face was triangulated, with no triangles if it is made of dead ends only
+ */
+bool triangulateFace(const Face *f, FaceTriangulationScratch &s) {
+    s.cut.clear();
+    s.rings.clear();
+    s.vertices.clear();
+    s.triangles.clear();
+    cutRings(f->rep, s);
+    for (const Face *hole = f->firstHole; hole != nullptr; hole = hole->nextHole) cutRings(hole->rep, s);
+    vector<double> area2(s.rings.size());
+    vector<long> owner(s.rings.size(), -1); // sub-ring around each hole
+    bool holes = false;
+    for (unsigned long r = 0; r < s.rings.size(); r++) {
+        area2[r] = ringArea2(s.rings[r], s);
+        holes = holes || area2[r] < 0;
+    }
+    for (unsigned long r = 0; holes && r < s.rings.size(); r++) {
+        if (area2[r] >= 0) continue;
+        const Vertex *a = s.cut[s.rings[r].first], *b = s.cut[s.rings[r].first + 1];
+        for (unsigned long o = 0; o < s.rings.size(); o++) {
+            if (area2[o] <= 0 || (owner[r] >= 0 && area2[owner[r]] <= area2[o])) continue;
+            if (ringContains(s.rings[o], (a->x + b->x) / 2, (a->y + b->y) / 2, s)) owner[r] = o;
+        }
+        if (owner[r] < 0) return false;
+    }
+    for (unsigned long o = 0; o < s.rings.size(); o++) {
+        if (area2[o] <= 0) continue;
+        unsigned long base = s.vertices.size();
+        s.vertices.insert(s.vertices.end(), s.cut.begin() + s.rings[o].first, s.cut.begin() + s.rings[o].second);
+        if (holes) {
+            vector<pair<uint32_t, uint32_t>> inside;
+            for (unsigned long r = 0; r < s.rings.size(); r++)
+                if (owner[r] == (long)o) inside.push_back(s.rings[r]);
+            auto rightmost = [&s](const pair<uint32_t, uint32_t> &r) {
+                const Vertex *m = s.cut[r.first];
+                for (uint32_t i = r.first + 1; i < r.second; i++)
+                    if (lexLess(m->x, m->y, s.cut[i]->x, s.cut[i]->y)) m = s.cut[i];
+                return m;
+            };
+            sort(inside.begin(), inside.end(), [&rightmost](const pair<uint32_t, uint32_t> &p, const pair<uint32_t, uint32_t> &q) {
+                const Vertex *a = rightmost(p), *b = rightmost(q);
+                return lexLess(b->x, b->y, a->x, a->y);
+            });
+            auto touching = [&s](const pair<uint32_t, uint32_t> &r) {
+                for (uint32_t i = r.first; i < r.second; i++)
+                    if (s.joined.count(s.cut[i]) != 0) return true;
+                return false;
+            };
+            s.joined.clear();
+            s.joined.insert(s.vertices.begin() + base, s.vertices.end());
+            while (!inside.empty()) {
+                // a bridge must not cut the face in two with a chain of holes touching the ring,
+                // so such holes are joined first where they touch
+                auto h = find_if(inside.begin(), inside.end(), touching);
+                if (h == inside.end()) h = inside.begin();
+                if (!joinHole(base, *h, inside, s)) return false;
+                inside.erase(h);
+            }
+        }
+        if (!triangulateRing(base, s)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Triangulate all the bounded faces of a DCEL using several threads
+ *
+ * Faces are split into one contiguous range of ids per thread, and every thread keeps the
+ * triangles of its range in its own FaceTriangulationScratch. Once the number of triangles
+ * of every face is known, a prefix sum gives where each range starts in the mesh and the
+ * threads copy their triangles there. Unbounded cycles get no triangles. Holes are only
+ * known once findHoles() (Holes.h) has linked them, before that the triangles of a face
+ * also cover the components lying inside it.
+ *
+ * @param dcel DCEL whose faces are triangulated, left unchanged
+ * @param threads number of threads to use, at least 1
+ * @return TriangleMesh triangles of every face, with corners given as positions in dcel.vertices
+ */
+TriangleMesh triangulateFaces(DCEL &dcel, unsigned threads = 1) {
+    PROFILE_SCOPE("triangulate faces");
+    if (threads < 1) threads = 1;
+    TriangleMesh mesh;
+    unsigned long nv = dcel.vertices.size(), nf = dcel.faces.size();
+    vector<pair<const Vertex *, uint32_t>> ids(nv);
+    parallelFor(0, nv, threads, [&](unsigned long i) { ids[i] = make_pair(dcel.vertices[i], (uint32_t)i); });
+    parallelSort(ids, [](const pair<const Vertex *, uint32_t> &a, const pair<const Vertex *, uint32_t> &b) {
+        return a.first < b.first;
+    }, threads);
+    auto idOf = [&ids](const Vertex *v) {
+        return lower_bound(ids.begin(), ids.end(), make_pair(v, (uint32_t)0))->second;
+    };
+    vector<FaceTriangulationScratch> scratch(threads);
+    mesh.offsets.assign(nf, 0);
+    parallelChunks(0, nf, threads, [&](unsigned t, unsigned long lo, unsigned long hi) {
+        FaceTriangulationScratch &s = scratch[t];
+        for (unsigned long i = lo; i < hi; i++) {
+            const Face *f = dcel.faces[i];
+            if (!measureFace(f).bounded()) continue;
+            if (!triangulateFace(f, s)) {
+                s.failed.push_back(i);
+                continue;
+            }
+            for (uint32_t k: s.triangles) s.corners.push_back(idOf(s.vertices[k]));
+            mesh.offsets[i] = s.triangles.size() / 3;
+        }
+    });
+    prefixSum(mesh.offsets, threads);
+    mesh.corners.resize(3 * (unsigned long)mesh.offsets.back());
+    parallelChunks(0, nf, threads, [&](unsigned t, unsigned long lo, unsigned long) {
+        copy(scratch[t].corners.begin(), scratch[t].corners.end(), mesh.corners.begin() + 3 * (unsigned long)mesh.offsets[lo]);
+    });
+    for (FaceTriangulationScratch &s: scratch) mesh.failed.insert(mesh.failed.end(), s.failed.begin(), s.failed.end());
+    return mesh;
+}
+
+#endif
@@ -69,7 +69,7 @@ class Vertex {
          * @return true if both coordinates match 
          * @return false if at least one coordinate differs
          */
-        bool operator==(const Vertex &v) {
+        bool operator==(const Vertex &v) const {
             // return (x == v.x) && (y == v.y);
             return (abs(x - v.x) < epsillion) && (abs(y - v.y) < epsillion);
         }
@@ -152,11 +152,19 @@ ostream& operator<<(ostream &os, const Edge &e) {
  * This Face class has an id and a representative HalfEdge which can be 
  * traversed to get the surrounding vertices and edges.
  * 
+ * Every cycle of half-edges is its own Face, so a component lying inside another face
+ * (an island) gets unrelated faces. findHoles() (Holes.h) links each clockwise cycle to
+ * the bounded face it lies in through outer, firstHole and nextHole. These links are only
+ * valid until the next edit of the DCEL.
+ * 
  */
 class Face {
     public:
         long long id;
         HalfEdge *rep; // rep->left == this
+        Face *outer; /**< bounded face whose outer boundary encloses this cycle: this face itself if its cycle is counter-clockwise, nullptr in the unbounded face */
+        Face *firstHole; /**< first clockwise cycle lying directly inside this face */
+        Face *nextHole; /**< next clockwise cycle lying directly inside the same face */
 
         /**
          * @brief Construct a new empty Face object
@@ -170,7 +178,8 @@ class Face {
          * @param Id id to be given to this face object (must be unique)
          * @param representative A HalfEdge to represent this face (can be any of the incident half edges)
          */
-        Face(long long Id, HalfEdge *representative): id(Id), rep(representative) {}
+        Face(long long Id, HalfEdge *representative): id(Id), rep(representative), outer(nullptr),
+            firstHole(nullptr), nextHole(nullptr) {}
 };
 
 ostream& operator<<(ostream &os, const Face &f) {
@@ -196,7 +205,6 @@ class HalfEdge {
         const Vertex *tail; /**< Vertex present at tail such that: twin->next->tail == tail && prev->twin->tail == tail */
         const Vertex *head; /**< Vertex present at head */
         Face *face; /**< prev->face == face && next->face == face */
-        double angle;
 
         /**
          * @brief Construct a new Half Edge object
@@ -208,9 +216,7 @@ class HalfEdge {
          * @param src source or the tail Vertex of the HalfEdge
          * @param dst destination or the head Vertex of the HalfEdge
          */
-        HalfEdge(const Vertex *src, const Vertex *dst): tail(src), head(dst), face(nullptr) {
-            angle = atan2(dst->y - src->y, dst->x - src->x);
-        }
+        HalfEdge(const Vertex *src, const Vertex *dst): tail(src), head(dst), face(nullptr) {}
 };
 
 ostream& operator<<(ostream &os, const HalfEdge &he) {
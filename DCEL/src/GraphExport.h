@@ -0,0 +1,229 @@
+/**
+ * @file GraphExport.h
+ * @brief This file contains the export of the vertex graph and the face adjacency graph of a DCEL
+ *
+ * Graph algorithms (shortest paths, region growing, flood fill) run best on flat arrays.
+ * primalGraph() and dualGraph() turn a DCEL into CSR graphs whose nodes are its vertices or
+ * its faces, using several threads and no map or hash table.
+ */
+
+#ifndef __GRAPHEXPORT_H__
+#define __GRAPHEXPORT_H__
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+
+#include "Geometry.h"
+#include "DCEL.h"
+#include "Circulators.h"
+#include "Parallel.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @brief Graph stored in CSR form
+ *
+ * The neighbours of node i are neighbours[offsets[i]] ... neighbours[offsets[i+1]-1]. Each
+ * entry also gives the id of the DCEL edge linking the two nodes and its length, so that
+ * two nodes linked by several edges have one entry per edge.
+ *
+ */
+struct CSRGraph {
+    vector<uint32_t> offsets; /**< start of the entries of each node, one more entry than nodes */
+    vector<uint32_t> neighbours; /**< node at the other end of each entry */
+    vector<uint32_t> edges; /**< id of the DCEL edge of each entry, see EdgeNumbering */
+    vector<double> lengths; /**< length of the DCEL edge of each entry */
+
+    /// Number of nodes in the graph
+    uint32_t numNodes() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    /// Number of entries of a node
+    uint32_t degree(uint32_t v) const { return offsets[v + 1] - offsets[v]; }
+};
+
+/**
+ * @brief Exclusive prefix sum of counts computed with several threads
+ *
+ * @param counts counts, replaced by their prefix sums; the total is appended
+ * @param threads number of threads to use, at least 1
+ */
+void prefixSum(vector<uint32_t> &counts, unsigned threads) {
+    if (threads < 1) threads = 1;
+    vector<uint32_t> chunkTotal(threads + 1, 0);
+    unsigned long n = counts.size();
+    parallelChunks(0, n, threads, [&](unsigned t, unsigned long lo, unsigned long hi) {
+        uint32_t sum = 0;
+        for (unsigned long i = lo; i < hi; i++) sum += counts[i];
+        chunkTotal[t + 1] = sum;
+    });
+    for (unsigned t = 0; t < threads; t++) chunkTotal[t + 1] += chunkTotal[t];
+    parallelChunks(0, n, threads, [&](unsigned t, unsigned long lo, unsigned long hi) {
+        uint32_t sum = chunkTotal[t];
+        for (unsigned long i = lo; i < hi; i++) {
+            uint32_t c = counts[i];
+            counts[i] = sum;
+            sum += c;
+        }
+    });
+    counts.push_back(chunkTotal[threads]); // chunks beyond the ones used add nothing
+}
+
+/**
+ * @class EdgeNumbering
+ * @brief Numbering of the half-edges and edges of a DCEL
+ *
+ * Half-edges are given slots vertex by vertex, in the order of DCEL::vertices, and clockwise
+ * around each vertex from its representative half-edge. An edge gets its id from the first
+ * of its two slots. Both only depend on the DCEL, so every export of the same DCEL uses the
+ * same ids. A half-edge is found from its pointer by binary search in a sorted copy of the
+ * slots, which is built with a parallel sort.
+ */
+class EdgeNumbering {
+    private:
+        vector<pair<const HalfEdge *, uint32_t>> sorted; /**< (half-edge, slot) sorted by half-edge */
+
+    public:
+        vector<uint32_t> offsets; /**< slots of vertex i are offsets[i] ... offsets[i+1]-1 */
+        vector<HalfEdge *> halfEdges; /**< half-edge in each slot */
+        vector<uint32_t> twin; /**< slot of the twin of the half-edge in each slot */
+        vector<uint32_t> edge; /**< id of the edge of the half-edge in each slot */
+        uint32_t numEdges; /**< number of edges */
+
+        /**
+         * @brief Number the half-edges and edges of a DCEL
+         *
+         * @param dcel DCEL object
+         * @param threads number of threads to use, at least 1
+         */
+        EdgeNumbering(const DCEL &dcel, unsigned threads = 1) {
+            PROFILE_SCOPE("edge numbering");
+            const vector<Vertex *> &vs = dcel.vertices;
+            offsets.resize(vs.size());
+            parallelFor(0, vs.size(), threads, [&](unsigned long v) {
+                Range<StarCirculator> star = vertexStar(vs[v]);
+                offsets[v] = distance(star.begin(), star.end());
+            });
+            prefixSum(offsets, threads);
+            unsigned long m = offsets.back();
+            halfEdges.resize(m);
+            sorted.resize(m);
+            parallelFor(0, vs.size(), threads, [&](unsigned long v) {
+                uint32_t k = offsets[v];
+                for (HalfEdge *h: vertexStar(vs[v])) {
+                    halfEdges[k] = h;
+                    sorted[k] = make_pair(h, k);
+                    k++;
+                }
+            });
+            parallelSort(sorted, [](const pair<const HalfEdge *, uint32_t> &a, const pair<const HalfEdge *, uint32_t> &b) {
+                return a.first < b.first;
+            }, threads);
+            twin.resize(m);
+            vector<uint32_t> first(m);
+            parallelFor(0, m, threads, [&](unsigned long k) {
+                twin[k] = slot(halfEdges[k]->twin);
+                first[k] = (k < twin[k]) ? 1 : 0;
+            });
+            prefixSum(first, threads);
+            numEdges = first.back();
+            edge.resize(m);
+            parallelFor(0, m, threads, [&](unsigned long k) {
+                edge[k] = (k < twin[k]) ? first[k] : first[twin[k]];
+            });
+        }
+
+        /**
+         * @brief Slot of a half-edge
+         *
+         * @param h HalfEdge of the DCEL
+         * @return uint32_t slot of h, in O(log n)
+         */
+        uint32_t slot(const HalfEdge *h) const {
+            auto i = lower_bound(sorted.begin(), sorted.end(), make_pair(h, (uint32_t)0));
+            return i->second;
+        }
+
+        /// Length of the half-edge in a slot
+        double length(uint32_t k) const {
+            const HalfEdge *h = halfEdges[k];
+            return hypot(h->head->x - h->tail->x, h->head->y - h->tail->y);
+        }
+};
+
+/**
+ * @brief Graph of the vertices and edges of a DCEL
+ *
+ * Node i is dcel.vertices[i], and its entries are the half-edges leaving it in clockwise
+ * order, so entry k of the graph is slot k of EdgeNumbering.
+ *
+ * @param dcel DCEL object
+ * @param threads number of threads to use, at least 1
+ * @return CSRGraph the vertex graph
+ */
+CSRGraph primalGraph(const DCEL &dcel, unsigned threads = 1) {
+    PROFILE_SCOPE("primal graph");
+    EdgeNumbering num(dcel, threads);
+    CSRGraph g;
+    g.offsets = num.offsets;
+    g.edges = num.edge;
+    unsigned long m = num.halfEdges.size();
+    g.neighbours.resize(m);
+    g.lengths.resize(m);
+    // the tail of the twin is the head, and the tail of slot k is the vertex owning it
+    vector<uint32_t> tail(m);
+    parallelFor(0, dcel.vertices.size(), threads, [&](unsigned long v) {
+        for (uint32_t k = num.offsets[v]; k < num.offsets[v + 1]; k++) tail[k] = v;
+    });
+    parallelFor(0, m, threads, [&](unsigned long k) {
+        g.neighbours[k] = tail[num.twin[k]];
+        g.lengths[k] = num.length(k);
+    });
+    return g;
+}
+
+/**
+ * @brief Face adjacency (dual) graph of a DCEL
+ *
+ * Node i is the face with id i, and its entries are the half-edges of its cycle in order,
+ * each linking it to the face on the other side of that half-edge. A face is its own
+ * neighbour across an edge having it on both sides, like a dead end road. Edge ids are the
+ * same as in primalGraph().
+ *
+ * @param dcel DCEL object
+ * @param threads number of threads to use, at least 1
+ * @return CSRGraph the face adjacency graph
+ */
+CSRGraph dualGraph(const DCEL &dcel, unsigned threads = 1) {
+    PROFILE_SCOPE("dual graph");
+    EdgeNumbering num(dcel, threads);
+    CSRGraph g;
+    const vector<Face *> &fs = dcel.faces;
+    g.offsets.resize(fs.size());
+    parallelFor(0, fs.size(), threads, [&](unsigned long f) {
+        Range<FaceCirculator> cycle = faceEdges(fs[f]);
+        g.offsets[f] = distance(cycle.begin(), cycle.end());
+    });
+    prefixSum(g.offsets, threads);
+    unsigned long m = g.offsets.back();
+    g.neighbours.resize(m);
+    g.edges.resize(m);
+    g.lengths.resize(m);
+    parallelFor(0, fs.size(), threads, [&](unsigned long f) {
+        uint32_t k = g.offsets[f];
+        for (HalfEdge *h: faceEdges(fs[f])) {
+            uint32_t s = num.slot(h);
+            g.neighbours[k] = h->twin->face->id;
+            g.edges[k] = num.edge[s];
+            g.lengths[k] = num.length(s);
+            k++;
+        }
+    });
+    return g;
+}
+
+#endif
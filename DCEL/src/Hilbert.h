@@ -0,0 +1,101 @@
+/**
+ * @file Hilbert.h
+ * @brief This file contains the Hilbert curve order used to lay out points close to each other
+ *
+ * The Hilbert curve visits every cell of a 2^16 x 2^16 grid once, moving to an adjacent cell
+ * at each step, so points with close positions along the curve are close in the plane.
+ * Sorting objects by the position of their point along the curve makes objects that are
+ * used together sit together in memory.
+ */
+
+#ifndef __HILBERT_H__
+#define __HILBERT_H__
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+#include "Parallel.h"
+
+using namespace std;
+
+/**
+ * @brief Position of a grid cell along the Hilbert curve
+ *
+ * @param x column of the cell, in [0, 2^16)
+ * @param y row of the cell, in [0, 2^16)
+ * @return uint64_t number of cells visited by the curve before this one
+ */
+uint64_t hilbertIndex(uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = 1u << 15; s > 0; s >>= 1) {
+        uint32_t rx = (x & s) ? 1 : 0, ry = (y & s) ? 1 : 0;
+        d += (uint64_t)s * s * ((3 * rx) ^ ry);
+        // rotate the quadrant so that the curve inside it starts at its lower left corner
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - (x & (s - 1));
+                y = s - 1 - (y & (s - 1));
+            }
+            swap(x, y);
+        }
+    }
+    return d;
+}
+
+/**
+ * @brief Position of a point along the Hilbert curve over a bounding box
+ *
+ * @param x x coordinate of the point
+ * @param y y coordinate of the point
+ * @param minX smallest x coordinate of the box
+ * @param minY smallest y coordinate of the box
+ * @param scale number of grid cells per unit of length
+ * @return uint64_t position of the grid cell holding the point
+ */
+uint64_t hilbertKey(double x, double y, double minX, double minY, double scale) {
+    const double last = 65535;
+    return hilbertIndex((uint32_t)min(last, max(0.0, floor((x - minX) * scale))),
+        (uint32_t)min(last, max(0.0, floor((y - minY) * scale))));
+}
+
+/**
+ * @brief Order of a list of points along the Hilbert curve over their bounding box
+ *
+ * Points in the same grid cell keep their relative order.
+ *
+ * @tparam GetX callable giving the x coordinate of the point with a given index
+ * @tparam GetY callable giving the y coordinate of the point with a given index
+ * @param n number of points
+ * @param getX x coordinate of each point
+ * @param getY y coordinate of each point
+ * @param threads number of threads to use, at least 1
+ * @return vector<unsigned long> indices of the points in curve order
+ */
+template <class GetX, class GetY>
+vector<unsigned long> hilbertOrder(unsigned long n, GetX getX, GetY getY, unsigned threads = 1) {
+    vector<unsigned long> order(n);
+    if (n == 0) return order;
+    double minX = getX(0), minY = getY(0), maxX = minX, maxY = minY;
+    for (unsigned long i = 1; i < n; i++) {
+        minX = min(minX, getX(i));
+        maxX = max(maxX, getX(i));
+        minY = min(minY, getY(i));
+        maxY = max(maxY, getY(i));
+    }
+    double side = max(maxX - minX, maxY - minY);
+    double scale = (side > 0) ? 65536 / side : 0;
+    vector<pair<uint64_t, unsigned long>> keys(n);
+    parallelFor(0, n, threads, [&](unsigned long i) {
+        keys[i] = make_pair(hilbertKey(getX(i), getY(i), minX, minY, scale), i);
+    });
+    parallelSort(keys, [](const pair<uint64_t, unsigned long> &a, const pair<uint64_t, unsigned long> &b) {
+        return a < b;
+    }, threads);
+    for (unsigned long i = 0; i < n; i++) order[i] = keys[i].second;
+    return order;
+}
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file Holes.h
+ * @brief This file contains a sweep line pass finding the holes of every face of a DCEL
+ *
+ * DCEL gives every cycle of half-edges its own Face. A bounded face is a counter-clockwise
+ * cycle, but a connected component lying inside it, like a building inside a block, only
+ * has a clockwise outer cycle which is not linked to that face. findHoles() finds, for
+ * every clockwise cycle, the bounded face it lies in with one sweep over the vertices.
+ */
+
+#ifndef __HOLES_H__
+#define __HOLES_H__
+
+#include <set>
+#include <vector>
+#include <algorithm>
+
+#include "Geometry.h"
+#include "DCEL.h"
+#include "Intersections.h"
+#include "Predicates.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @brief Functor ordering edges crossing the sweep line from bottom to top
+ *
+ * Edges are given by their half-edge going from their lexicographically smaller endpoint
+ * to the larger one. Since edges of a DCEL do not cross, two edges crossing the sweep line
+ * are ordered by the side of the one whose left endpoint comes later, seen from the other
+ * one. A point is ordered against an edge by its side of the edge. All tests are exact.
+ */
+struct SweepBelow {
+    typedef void is_transparent;
+
+    /// side of point (x, y) with respect to the line through h: +1 above, -1 below, 0 on it
+    static int side(const HalfEdge *h, double x, double y) {
+        return orientExact(h->tail->x, h->tail->y, h->head->x, h->head->y, x, y);
+    }
+
+    bool operator()(const HalfEdge *s, const HalfEdge *t) const {
+        if (s == t) return false;
+        if (!lexLess(t->tail->x, t->tail->y, s->tail->x, s->tail->y)) {
+            int o = side(s, t->tail->x, t->tail->y);
+            if (o == 0) o = side(s, t->head->x, t->head->y); // shared left endpoint
+            return o > 0;
+        }
+        int o = side(t, s->tail->x, s->tail->y);
+        if (o == 0) o = side(t, s->head->x, s->head->y);
+        return o < 0;
+    }
+
+    bool operator()(const HalfEdge *s, const Vertex &v) const { return side(s, v.x, v.y) > 0; }
+    bool operator()(const Vertex &v, const HalfEdge *s) const { return side(s, v.x, v.y) < 0; }
+};
+
+/**
+ * @brief Link every clockwise cycle of a DCEL to the bounded face it lies in
+ *
+ * The leftmost vertex v (in (x, y) order) of every cycle is found first. Every edge at v
+ * goes right, so the cycle turns left at v when it is counter-clockwise, and it is the
+ * outer boundary of a component, hence clockwise, when it turns right at one of its passes
+ * through v, since its face then contains the points just left of v. The turns are exact;
+ * a cycle going straight back at v, along a dead end or a repeated edge, is classified by
+ * the sign of its area instead. Counter-clockwise cycles are bounded faces and get
+ * f->outer = f.
+ *
+ * A sweep line then moves over the vertices in (x, y) order, keeping the edges it crosses
+ * ordered from bottom to top. At the leftmost vertex of a clockwise cycle, the first edge
+ * above it lies on the boundary of the region containing the cycle: the cycle below that
+ * edge is either a bounded face or the clockwise cycle of another component, which was
+ * met earlier by the sweep and whose outer face is then taken. With no edge above, the
+ * cycle lies in the unbounded face. Each hole is added to the list firstHole, nextHole of
+ * its outer face. Takes O(n log n) time for n edges.
+ *
+ * The links are not updated by edits of the DCEL, the pass must be run again after them.
+ *
+ * @param dcel DCEL object whose faces are linked
+ * @return vector<Face *> clockwise cycles lying in the unbounded face, one per outermost component
+ */
+vector<Face *> findHoles(DCEL &dcel) {
+    PROFILE_SCOPE("holes");
+    // leftmost vertex of every cycle, and whether the cycle is clockwise
+    vector<const Vertex *> leftmost(dcel.faces.size());
+    vector<char> clockwise(dcel.faces.size(), 0);
+    for (Face *f: dcel.faces) {
+        f->outer = f->firstHole = f->nextHole = nullptr;
+        const HalfEdge *h = f->rep;
+        const Vertex *v = h->tail;
+        double x0 = v->x, y0 = v->y, area2 = 0;
+        do {
+            if (lexLess(h->tail->x, h->tail->y, v->x, v->y)) v = h->tail;
+            area2 += (h->tail->x - x0) * (h->head->y - y0) - (h->head->x - x0) * (h->tail->y - y0);
+            h = h->next;
+        } while (h != f->rep);
+        leftmost[f->id] = v;
+        // a right turn at v, where the cycle may pass several times, keeps the points just left
+        // of v in its face; the signed area decides when no turn is right and one is straight
+        int turn = 1;
+        do {
+            if (h->tail == v) {
+                const Vertex *u = h->prev->tail, *w = h->head;
+                turn = min(turn, orientExact(u->x, u->y, v->x, v->y, w->x, w->y));
+            }
+            h = h->next;
+        } while (h != f->rep && turn >= 0);
+        clockwise[f->id] = (turn < 0 || (turn == 0 && area2 <= 0));
+        if (!clockwise[f->id]) f->outer = f;
+    }
+
+    // clockwise cycles by vertex, to be resolved when the sweep reaches it
+    vector<Vertex *> order(dcel.vertices);
+    sort(order.begin(), order.end(), [](const Vertex *a, const Vertex *b) { return lexLess(a->x, a->y, b->x, b->y); });
+    vector<Face *> holes;
+    for (Face *f: dcel.faces) if (clockwise[f->id]) holes.push_back(f);
+    sort(holes.begin(), holes.end(), [&](const Face *a, const Face *b) {
+        const Vertex *p = leftmost[a->id], *q = leftmost[b->id];
+        return lexLess(p->x, p->y, q->x, q->y);
+    });
+
+    set<HalfEdge *, SweepBelow> status;
+    vector<Face *> outermost;
+    unsigned long next = 0;
+    for (Vertex *v: order) {
+        for (; next < holes.size() && leftmost[holes[next]->id] == v; next++) {
+            Face *f = holes[next];
+            PROFILE_COUNT(SWEEP_STATUS_OPS);
+            auto above = status.upper_bound(*v);
+            if (above == status.end()) {
+                outermost.push_back(f);
+                continue;
+            }
+            Face *below = (*above)->twin->face; // face below the edge
+            f->outer = below->outer;
+            if (f->outer != nullptr) {
+                f->nextHole = f->outer->firstHole;
+                f->outer->firstHole = f;
+            }
+            else outermost.push_back(f);
+        }
+        // edges ending at v leave the status before those starting at v enter it
+        for (HalfEdge *e: dcel.heMap[v]) {
+            if (lexLess(e->head->x, e->head->y, v->x, v->y)) {
+                PROFILE_COUNT(SWEEP_STATUS_OPS);
+                status.erase(e->twin);
+            }
+        }
+        for (HalfEdge *e: dcel.heMap[v]) {
+            if (lexLess(v->x, v->y, e->head->x, e->head->y)) {
+                PROFILE_COUNT(SWEEP_STATUS_OPS);
+                status.insert(e);
+            }
+        }
+    }
+    return outermost;
+}
+
+#endif
@@ -0,0 +1,430 @@
+/**
+ * @file Intersections.h
+ * @brief This file contains a sweep line pass splitting edges where they intersect
+ *
+ * DCEL assumes that edges only meet at common endpoints, while road networks often have
+ * edges crossing each other or ending in the middle of another edge. splitIntersections()
+ * finds all these points with the Bentley-Ottmann sweep in O((n + k) log n) time for n edges
+ * and k intersections and splits the edges there, so that its output can be given to DCEL.
+ */
+
+#ifndef __INTERSECTIONS_H__
+#define __INTERSECTIONS_H__
+
+#include <set>
+#include <queue>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "Geometry.h"
+#include "Parallel.h"
+#include "Predicates.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/// true if point (ax, ay) is lexicographically smaller than point (bx, by)
+bool lexLess(double ax, double ay, double bx, double by) {
+    return ax < bx || (ax == bx && ay < by);
+}
+
+/**
+ * @class SegmentSweep
+ * @brief Bentley-Ottmann sweep over the segments overlapping a vertical slab
+ *
+ * The sweep line moves from left to right and points are ordered lexicographically by
+ * (x, y), so vertical segments need no special case. The status holds the segments cut by
+ * the sweep line ordered from bottom to top. Every event point is handled once with all
+ * the segments going through it, as in chapter 2 of "Computational Geometry: Algorithms
+ * and Applications" (de Berg et al.), so that endpoints lying on other segments and many
+ * segments meeting at one point are found. Crossings interior to two segments are looked
+ * for between neighbours of the status and queued as new event points.
+ *
+ * Whether two segments intersect and whether a point lies on a segment are decided exactly
+ * with orientExact(), only the coordinates of a crossing are rounded. Two crossing segments
+ * swap in the status when the sweep reaches their rounded crossing, which is also the
+ * position of their crossing event, so the order of the status stays consistent. In very
+ * dense clusters of crossings, rounding can still place two events out of order and a
+ * crossing may then be missed; road networks are far from this case.
+ *
+ * The slab [left, right) only reports the points whose x lies in it, hence sweeps over
+ * slabs partitioning the plane report every point exactly once and can run in parallel.
+ */
+class SegmentSweep {
+    public:
+        /// Segment from (x1, y1) to (x2, y2), the first point being lexicographically smaller
+        struct Segment {
+            double x1, y1, x2, y2;
+        };
+
+        /// Point where a segment has to be split
+        struct SplitPoint {
+            unsigned long segment; /**< index of the segment */
+            double x, y; /**< coordinates of the point */
+        };
+
+    private:
+        enum EventKind { END, CROSS, START };
+
+        /// Event of the sweep
+        struct Event {
+            double x, y;
+            EventKind kind;
+            long a, b; /**< local index of the segment(s) concerned, b is only used by crossings */
+        };
+
+        /// Priority of events, the smallest point comes out of the queue first
+        struct Later {
+            bool operator()(const Event &e, const Event &f) const {
+                if (e.x != f.x || e.y != f.y) return lexLess(f.x, f.y, e.x, e.y);
+                if (e.kind != f.kind) return e.kind > f.kind;
+                return make_pair(e.a, e.b) > make_pair(f.a, f.b);
+            }
+        };
+
+        /// Order of the status, from bottom to top at the current position of the sweep
+        struct Below {
+            const SegmentSweep *sweep;
+            bool operator()(long s, long t) const {
+                return sweep->below(s, t);
+            }
+        };
+
+        typedef set<long, Below> Status;
+
+        static const long eventPoint = -1; /**< key standing for the current event point in status searches */
+
+        const vector<Segment> &segs; /**< all segments */
+        vector<unsigned long> ids; /**< segments overlapping the slab, the local index of a segment is its position here */
+        double left, right; /**< bounds of the slab */
+        double ex, ey; /**< current event point */
+        bool started; /**< false while the segments crossing the left side of the slab are inserted */
+        Status status; /**< segments cut by the sweep line */
+        vector<Status::iterator> handle; /**< position of each segment in the status */
+        vector<bool> active; /**< true while a segment is in the status */
+        priority_queue<Event, vector<Event>, Later> events; /**< pending events */
+        set<pair<long, long>> crossings; /**< crossing pairs already found */
+        vector<long> late; /**< segments of crossings found after the sweep passed them */
+        vector<SplitPoint> &found; /**< split points reported by the sweep */
+
+        const Segment& seg(long s) const {
+            return segs[ids[s]];
+        }
+
+        /// Orientation of point (x, y) with respect to segment s: +1 above, -1 below, 0 on its line
+        int side(long s, double x, double y) const {
+            const Segment &a = seg(s);
+            return orientExact(a.x1, a.y1, a.x2, a.y2, x, y);
+        }
+
+        /// true if the current event point lies on the line of segment s
+        bool throughEvent(long s) const {
+            return started && side(s, ex, ey) == 0;
+        }
+
+        /**
+         * @brief Rounded crossing point of two segments crossing at a point interior to both
+         *
+         * The result is computed in extended precision, so that a crossing which is exactly
+         * representable is usually found exactly. It does not depend on the order of s and t
+         * and is clamped to the part of the plane swept by both segments.
+         */
+        void crossPoint(long s, long t, double &x, double &y) const {
+            const Segment &a = seg(min(s, t)), &b = seg(max(s, t));
+            long double dax = (long double) a.x2 - a.x1, day = (long double) a.y2 - a.y1;
+            long double dbx = (long double) b.x2 - b.x1, dby = (long double) b.y2 - b.y1;
+            long double u = (((long double) b.x1 - a.x1) * dby - ((long double) b.y1 - a.y1) * dbx) / (dax * dby - day * dbx);
+            x = (double) (a.x1 + u * dax);
+            y = (double) (a.y1 + u * day);
+            if (lexLess(x, y, a.x1, a.y1)) x = a.x1, y = a.y1;
+            if (lexLess(x, y, b.x1, b.y1)) x = b.x1, y = b.y1;
+            if (lexLess(a.x2, a.y2, x, y)) x = a.x2, y = a.y2;
+            if (lexLess(b.x2, b.y2, x, y)) x = b.x2, y = b.y2;
+        }
+
+        /**
+         * @brief Whether segment s is below segment t just right of the current event point
+         *
+         * Segments going through the event point are ordered by their direction after it.
+         * Other segments which do not cross keep the same order along the whole sweep and it
+         * is found from their endpoints, while crossing segments swap once the sweep reaches
+         * their crossing. Overlapping collinear segments are ordered by index. The key
+         * eventPoint compares as the event point itself.
+         */
+        bool below(long s, long t) const {
+            if (s == t) return false;
+            if (t == eventPoint) return side(s, ex, ey) > 0;
+            if (s == eventPoint) return side(t, ex, ey) < 0;
+            const Segment &a = seg(s), &b = seg(t);
+            int o1 = side(s, b.x1, b.y1), o2 = side(s, b.x2, b.y2), o;
+            if (throughEvent(s) && throughEvent(t)) o = o2;
+            else if (o1 * o2 < 0 && side(t, a.x1, a.y1) * side(t, a.x2, a.y2) < 0) {
+                bool before = lexLess(a.x1, a.y1, b.x1, b.y1) ? o1 > 0 : side(t, a.x1, a.y1) < 0;
+                double x, y;
+                crossPoint(s, t, x, y);
+                return lexLess(ex, ey, x, y) ? before : !before;
+            }
+            else if (a.x1 == b.x1 && a.y1 == b.y1) o = o2;
+            else if (lexLess(a.x1, a.y1, b.x1, b.y1)) o = (o1 != 0) ? o1 : o2;
+            else {
+                o = -side(t, a.x1, a.y1);
+                if (o == 0) o = -side(t, a.x2, a.y2);
+            }
+            return (o != 0) ? o > 0 : s < t;
+        }
+
+        /// Report that segment s must be split at (x, y), unless the point is outside the slab or not interior to s
+        void report(long s, double x, double y) {
+            const Segment &a = seg(s);
+            if (x < left || x >= right) return;
+            if (lexLess(a.x1, a.y1, x, y) && lexLess(x, y, a.x2, a.y2)) found.push_back({ids[s], x, y});
+        }
+
+        /**
+         * @brief Look for a crossing between two segments which became neighbours
+         *
+         * A crossing interior to both segments is queued once. If the sweep already reached
+         * it, it is reported at once and both segments are added to late so that they are
+         * moved to their order after the crossing. Endpoints lying on the other segment need
+         * no check as they are event points themselves.
+         */
+        void check(long s, long t) {
+            const Segment &a = seg(s), &b = seg(t);
+            if (side(s, b.x1, b.y1) * side(s, b.x2, b.y2) >= 0 || side(t, a.x1, a.y1) * side(t, a.x2, a.y2) >= 0) return;
+            if (!crossings.insert(make_pair(min(s, t), max(s, t))).second) return;
+            double x, y;
+            crossPoint(s, t, x, y);
+            if (lexLess(ex, ey, x, y)) {
+                if (x < right) events.push({x, y, CROSS, min(s, t), max(s, t)});
+            }
+            else {
+                // the crossing was passed along with another one rounded to the same point
+                report(s, x, y);
+                report(t, x, y);
+                late.push_back(s);
+                late.push_back(t);
+            }
+        }
+
+        /// Insert a segment in the status
+        void insert(long s) {
+            PROFILE_COUNT(SWEEP_STATUS_OPS);
+            handle[s] = status.insert(s).first;
+            active[s] = true;
+        }
+
+        /// Remove a segment from the status
+        void erase(long s) {
+            PROFILE_COUNT(SWEEP_STATUS_OPS);
+            status.erase(handle[s]);
+            active[s] = false;
+        }
+
+        /// Check a segment of the status against the segments right below and above it
+        void checkNeighbours(long s) {
+            Status::iterator it = handle[s];
+            if (it != status.begin()) check(*prev(it), s);
+            if (next(it) != status.end()) check(s, *next(it));
+        }
+
+        /**
+         * @brief Handle all the events at the current event point
+         *
+         * The segments going through the point are the ones of the crossings queued at this
+         * point, which may miss it by a rounding error, and the ones of the status lying
+         * exactly on it, found around the point and around the segments of its events.
+         * They are split there, taken out of the status and, unless they end there, inserted
+         * again with the segments starting there in their order right of the point. Every
+         * segment which got a new neighbour is then checked against its neighbours. Crossings
+         * so close to each other that their rounded points are equal or out of order can
+         * only be found at this stage and their segments are moved in turn.
+         */
+        void handleEventPoint() {
+            vector<long> through, starts;
+            while (!events.empty() && events.top().x == ex && events.top().y == ey) {
+                Event e = events.top();
+                events.pop();
+                if (e.kind == START) starts.push_back(e.a);
+                else {
+                    if (active[e.a]) through.push_back(e.a);
+                    if (e.kind == CROSS && active[e.b]) through.push_back(e.b);
+                }
+            }
+            // the segments going through the point are next to the ones of its events or to its position in the status
+            PROFILE_COUNT(SWEEP_STATUS_OPS);
+            vector<Status::iterator> seeds(1, status.lower_bound(eventPoint));
+            for (long s: through) seeds.push_back(handle[s]);
+            for (Status::iterator it: seeds) {
+                Status::iterator up = it, down = it;
+                if (it != status.end() && side(*it, ex, ey) == 0) through.push_back(*it);
+                while (up != status.end() && ++up != status.end() && side(*up, ex, ey) == 0) through.push_back(*up);
+                while (down != status.begin() && side(*--down, ex, ey) == 0) through.push_back(*down);
+            }
+            sort(through.begin(), through.end());
+            through.erase(unique(through.begin(), through.end()), through.end());
+
+            for (long s: through) report(s, ex, ey);
+
+            // crossings found late are fixed by moving their segments again
+            vector<long> moved = through;
+            moved.insert(moved.end(), starts.begin(), starts.end());
+            while (!moved.empty()) {
+                vector<long> touched;
+                for (long s: moved) {
+                    if (!active[s]) continue;
+                    if (handle[s] != status.begin()) touched.push_back(*prev(handle[s]));
+                    if (next(handle[s]) != status.end()) touched.push_back(*next(handle[s]));
+                    erase(s);
+                }
+                touched.insert(touched.end(), moved.begin(), moved.end());
+                for (long s: touched)
+                    if (!active[s] && lexLess(ex, ey, seg(s).x2, seg(s).y2)) insert(s);
+                late.clear();
+                for (long s: touched)
+                    if (active[s]) checkNeighbours(s);
+                moved = late;
+            }
+        }
+
+    public:
+        /**
+         * @brief Prepare a sweep over the segments overlapping the slab [Left, Right)
+         *
+         * @param Segs all segments
+         * @param Left left bound of the slab, -infinity for the first one
+         * @param Right right bound of the slab, +infinity for the last one
+         * @param Found vector receiving the split points
+         */
+        SegmentSweep(const vector<Segment> &Segs, double Left, double Right, vector<SplitPoint> &Found):
+            segs(Segs), left(Left), right(Right), ex(Left), ey(-numeric_limits<double>::infinity()),
+            started(false), status(Below{this}), found(Found) {
+            for (unsigned long i = 0; i < segs.size(); i++)
+                if (segs[i].x1 < right && segs[i].x2 >= left) ids.push_back(i);
+            handle.resize(ids.size());
+            active.assign(ids.size(), false);
+        }
+
+        SegmentSweep(const SegmentSweep &) = delete;
+        SegmentSweep& operator=(const SegmentSweep &) = delete;
+
+        /**
+         * @brief Run the sweep, appending the split points lying in the slab to Found
+         *
+         * Segments already cut by the left side of the slab are inserted in the status at
+         * once, their crossings left of the slab are not reported. The sweep stops at the
+         * right side of the slab.
+         */
+        void run() {
+            for (unsigned long s = 0; s < ids.size(); s++) {
+                const Segment &a = seg(s);
+                if (a.x1 < left) insert(s);
+                else events.push({a.x1, a.y1, START, (long) s, -1});
+                if (a.x2 < right) events.push({a.x2, a.y2, END, (long) s, -1});
+            }
+            for (Status::iterator it = status.begin(); it != status.end() && next(it) != status.end(); it++)
+                check(*it, *next(it));
+
+            started = true;
+            while (!events.empty()) {
+                ex = events.top().x;
+                ey = events.top().y;
+                handleEventPoint();
+            }
+        }
+};
+
+const long SegmentSweep::eventPoint;
+
+/**
+ * @brief Split edges at the points where they cross or touch each other
+ *
+ * Every edge is split at the points of its interior where it crosses another edge, where
+ * another edge ends, or where a collinear edge overlapping it ends. Edges which need no
+ * split are copied unchanged and the pieces of an edge are given in order from its src to
+ * its dst, so the output keeps the order of the input. Crossing points are rounded to the
+ * nearest doubles, DCEL merges the resulting points lying within epsillion of each other.
+ *
+ * With more than one thread, the plane is cut into vertical slabs holding about as many
+ * endpoints each and every slab is swept on its own thread. A segment spanning several
+ * slabs is swept in each of them but its intersections are only reported by the slab
+ * containing them, hence the output does not depend on the number of threads.
+ *
+ * @param edges list of Edge objects, which may cross each other
+ * @param threads number of threads (and slabs) to use, at least 1
+ * @param source if not nullptr, filled with the index of the input edge each output edge comes from
+ * @return vector<Edge> list of edges only meeting at common endpoints
+ */
+vector<Edge> splitIntersections(const vector<Edge> &edges, unsigned threads = 1, vector<unsigned long> *source = nullptr) {
+    PROFILE_SCOPE("intersections");
+    vector<SegmentSweep::Segment> segs;
+    vector<long> segOf(edges.size(), -1);
+    for (unsigned long i = 0; i < edges.size(); i++) {
+        const Vertex &a = edges[i].src, &b = edges[i].dst;
+        if (a.x == b.x && a.y == b.y) continue;
+        segOf[i] = segs.size();
+        if (lexLess(a.x, a.y, b.x, b.y)) segs.push_back({a.x, a.y, b.x, b.y});
+        else segs.push_back({b.x, b.y, a.x, a.y});
+    }
+
+    // slab bounds are quantiles of the x coordinates of the endpoints
+    const double inf = numeric_limits<double>::infinity();
+    vector<double> bounds(1, -inf);
+    if (threads > 1 && !segs.empty()) {
+        vector<double> xs;
+        for (const SegmentSweep::Segment &s: segs) {
+            xs.push_back(s.x1);
+            xs.push_back(s.x2);
+        }
+        sort(xs.begin(), xs.end());
+        for (unsigned t = 1; t < threads; t++)
+            if (xs[t * xs.size() / threads] > bounds.back()) bounds.push_back(xs[t * xs.size() / threads]);
+    }
+    bounds.push_back(inf);
+
+    vector<vector<SegmentSweep::SplitPoint>> found(bounds.size() - 1);
+    parallelFor(0, found.size(), threads, [&](unsigned long k) {
+        SegmentSweep sweep(segs, bounds[k], bounds[k + 1], found[k]);
+        sweep.run();
+    });
+
+    vector<SegmentSweep::SplitPoint> splits;
+    for (vector<SegmentSweep::SplitPoint> &f: found) splits.insert(splits.end(), f.begin(), f.end());
+    sort(splits.begin(), splits.end(), [](const SegmentSweep::SplitPoint &a, const SegmentSweep::SplitPoint &b) {
+        if (a.segment != b.segment) return a.segment < b.segment;
+        return lexLess(a.x, a.y, b.x, b.y);
+    });
+    splits.erase(unique(splits.begin(), splits.end(), [](const SegmentSweep::SplitPoint &a, const SegmentSweep::SplitPoint &b) {
+        return a.segment == b.segment && a.x == b.x && a.y == b.y;
+    }), splits.end());
+    vector<unsigned long> first(segs.size() + 1, 0);
+    for (const SegmentSweep::SplitPoint &p: splits) first[p.segment + 1]++;
+    for (unsigned long s = 0; s < segs.size(); s++) first[s + 1] += first[s];
+
+    vector<Edge> result;
+    result.reserve(edges.size() + splits.size());
+    if (source != nullptr) source->clear();
+    for (unsigned long i = 0; i < edges.size(); i++) {
+        long s = segOf[i];
+        if (source != nullptr) source->resize(result.size() + ((s == -1) ? 1 : first[s + 1] - first[s] + 1), i);
+        if (s == -1 || first[s] == first[s + 1]) {
+            result.push_back(edges[i]);
+            continue;
+        }
+        // the split points of a segment are sorted from its first point, which is src or dst
+        const Vertex &a = edges[i].src, &b = edges[i].dst;
+        bool forward = lexLess(a.x, a.y, b.x, b.y);
+        double x = a.x, y = a.y;
+        for (unsigned long k = 0; k < first[s + 1] - first[s]; k++) {
+            const SegmentSweep::SplitPoint &p = splits[forward ? first[s] + k : first[s + 1] - 1 - k];
+            result.emplace_back(x, y, p.x, p.y);
+            x = p.x;
+            y = p.y;
+        }
+        result.emplace_back(x, y, b.x, b.y);
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,316 @@
+/**
+ * @file Overlay.h
+ * @brief This file contains the overlay of two planar subdivisions stored as DCELs
+ *
+ * The overlay of two subdivisions A and B is the subdivision cut by the edges of both. Each
+ * of its faces lies inside one face of A and one face of B, for example a city block inside
+ * a zoning area. MapOverlay builds the overlay and records these two faces for every face.
+ */
+
+#ifndef __OVERLAY_H__
+#define __OVERLAY_H__
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Geometry.h"
+#include "DCEL.h"
+#include "FaceMetrics.h"
+#include "Intersections.h"
+#include "PointLocation.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @class MapOverlay
+ * @brief Overlay of two DCELs with the source faces of every face
+ *
+ * The overlay starts as a copy of A. The edges of both DCELs are split where they cross or
+ * touch with the sweep of splitIntersections(), in O((n + k) log n) time for n edges and k
+ * intersections. The copied edges of A are then cut at their split points with
+ * DCEL::splitEdge(), and the pieces of B are added with DCEL::addEdges(), so only the
+ * split edges and the stars and faces reached by B are changed. Pieces shared by both
+ * inputs (overlapping collinear edges) are kept once, while repeated edges of one input
+ * stay separate pieces as in the DCEL constructor, and zero-length pieces of B are left
+ * out. Every half-edge of the overlay remembers the half-edge of A and of B it comes from,
+ * so the face of A of an overlay face is read from any of its boundary half-edges coming
+ * from A. A face bounded only by edges of B lies inside a single face of A, which is found
+ * by locating the middle of one of its edges in a TrapezoidalMap of A, built only if such a
+ * face exists; and the same holds with A and B swapped.
+ *
+ * Faces of A and B are cycles of half-edges as in DCEL, so the source face of a region is
+ * the cycle directly around it, as given by TrapezoidalMap::locate(). Both input DCELs are
+ * left unchanged and must outlive the overlay when its source faces are used.
+ */
+class MapOverlay {
+    private:
+        unordered_map<const HalfEdge *, HalfEdge *> sourceA; /**< half-edge of A each half-edge of the overlay comes from */
+        unordered_map<const HalfEdge *, HalfEdge *> sourceB; /**< half-edge of B each half-edge of the overlay comes from */
+
+        /**
+         * @brief Append the edges of a DCEL, one per pair of twin half-edges
+         *
+         * @param d DCEL whose edges are listed
+         * @param edges list to which the edges are appended
+         * @param halfEdges list to which the half-edge of every edge is appended
+         */
+        static void collect(DCEL &d, vector<Edge> &edges, vector<HalfEdge *> &halfEdges) {
+            for (Vertex *v: d.vertices) {
+                for (HalfEdge *h: d.heMap[v]) {
+                    if (h > h->twin) continue;
+                    edges.emplace_back(h->tail->x, h->tail->y, h->head->x, h->head->y);
+                    halfEdges.push_back(h);
+                }
+            }
+        }
+
+        /**
+         * @brief Sort parallel half-edges of a DCEL by their position in the star of their tail
+         *
+         * Parallel half-edges are equal in the star, which keeps them in the order they were
+         * linked in, so this is also their clockwise order.
+         *
+         * @param copies half-edges of d with the same tail and head
+         * @param d DCEL of the half-edges
+         */
+        static void starOrder(vector<HalfEdge *> &copies, DCEL &d) {
+            if (copies.size() < 2) return;
+            auto same = d.heMap[const_cast<Vertex *>(copies[0]->tail)].equal_range(copies[0]);
+            unordered_map<HalfEdge *, unsigned long> rank;
+            for (auto it = same.first; it != same.second; ++it) rank.emplace(*it, rank.size());
+            sort(copies.begin(), copies.end(), [&rank](HalfEdge *p, HalfEdge *q) { return rank[p] < rank[q]; });
+        }
+
+        /**
+         * @brief Record the half-edge of a source DCEL a new edge of the overlay comes from
+         *
+         * @param h half-edge of the overlay
+         * @param from half-edge of the source in the direction of h
+         * @param source sourceA or sourceB
+         */
+        static void attach(HalfEdge *h, HalfEdge *from, unordered_map<const HalfEdge *, HalfEdge *> &source) {
+            source[h] = from;
+            source[h->twin] = from->twin;
+        }
+
+        /**
+         * @brief Whether an edge of the overlay can be split at a point by DCEL::splitEdge()
+         *
+         * Split points are rounded, so the new half-edges may turn past a nearly collinear
+         * neighbour in the stars of the endpoints, whose order must not change.
+         *
+         * @param h half-edge of the edge
+         * @param p split point, not equal to any vertex of the overlay
+         * @return true if both halves keep the place of the edge in the stars of its endpoints
+         */
+        bool keepsOrder(HalfEdge *h, const Vertex &p) {
+            for (HalfEdge *e: {h, h->twin}) {
+                HalfEdge half(e->tail, &p);
+                Star &star = dcel.heMap[const_cast<Vertex *>(e->tail)];
+                auto same = star.equal_range(e);
+                auto i = find(same.first, same.second, e);
+                if (i != star.begin() && compare(&half, *prev(i))) return false;
+                if (next(i) != star.end() && compare(*next(i), &half)) return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Cut the copied edges of A at the points where the edges of B cross them
+         *
+         * @param halfEdges half-edge of the copy of every edge of A, in the order of edges
+         * @param points points lying inside each edge of A, in any order
+         * @param added filled with the pieces of edges of A which must be added as new edges
+         * @param addedFrom half-edge of A every added piece comes from
+         */
+        void cutEdges(const vector<HalfEdge *> &halfEdges, vector<vector<Vertex>> &points,
+                vector<Edge> &added, vector<HalfEdge *> &addedFrom) {
+            for (unsigned long k = 0; k < points.size(); k++) {
+                if (points[k].empty()) continue;
+                HalfEdge *h = halfEdges[k];
+                bool forward = lexLess(h->tail->x, h->tail->y, h->head->x, h->head->y);
+                sort(points[k].begin(), points[k].end(), [forward](const Vertex &p, const Vertex &q) {
+                    return forward ? lexLess(p.x, p.y, q.x, q.y) : lexLess(q.x, q.y, p.x, p.y);
+                });
+                points[k].erase(unique(points[k].begin(), points[k].end(), [](const Vertex &p, const Vertex &q) {
+                    return p == q;
+                }), points[k].end());
+                unsigned long i = 0;
+                for (; i < points[k].size() && dcel.getVertex(points[k][i]) == nullptr && keepsOrder(h, points[k][i]); i++) {
+                    dcel.splitEdge(h, points[k][i]);
+                    HalfEdge *m = h->next; // the new edge from the split point, its only other edge
+                    attach(m, sourceA[h], sourceA);
+                    h = m;
+                }
+                if (i == points[k].size()) continue;
+                // the rest of the edge goes through a vertex which is already in the overlay, or
+                // bends too much at the split point, so it is replaced by its pieces
+                Vertex tail = *h->tail, head = *h->head;
+                HalfEdge *from = sourceA[h];
+                sourceA.erase(h);
+                sourceA.erase(h->twin);
+                dcel.removeEdge(h);
+                for (; i <= points[k].size(); i++) {
+                    const Vertex &q = (i < points[k].size()) ? points[k][i] : head;
+                    added.emplace_back(tail.x, tail.y, q.x, q.y);
+                    addedFrom.push_back(from);
+                    tail = q;
+                }
+            }
+        }
+
+        /**
+         * @brief Add edges to the overlay and record the half-edge of a source they come from
+         *
+         * @param added edges to be added
+         * @param from half-edge of the source every edge comes from, in the direction of the edge
+         * @param source sourceA or sourceB
+         */
+        void addEdges(vector<Edge> &added, const vector<HalfEdge *> &from, unordered_map<const HalfEdge *, HalfEdge *> &source) {
+            if (added.empty()) return;
+            vector<HalfEdge *> created;
+            dcel.addEdges(added, &created);
+            for (unsigned long i = 0; i < created.size(); i++) attach(created[i], from[i], source);
+        }
+
+        /**
+         * @brief Whether a face of a source DCEL has zero area
+         *
+         * Such a cycle runs along a tree of edges, or between repeated edges, and holds no
+         * region, so it is not the source face of the overlay faces along its edges.
+         *
+         * @param f face of the source DCEL
+         * @param known per face id of the source, 1 if flat, 0 if not and -1 if not measured yet
+         * @return true if the signed area of f is zero
+         */
+        static bool flat(const Face *f, vector<signed char> &known) {
+            if (known[f->id] < 0) known[f->id] = (measureFace(f).area == 0);
+            return known[f->id] == 1;
+        }
+
+        /**
+         * @brief Find the face of a source DCEL containing an overlay face with no edge from it
+         *
+         * @param f overlay face
+         * @param index point location index over the source DCEL, built on first use
+         * @param source source DCEL
+         * @return Face* face of the source DCEL around the middle of the first edge of f
+         */
+        Face* locateFace(const Face *f, unique_ptr<TrapezoidalMap> &index, DCEL &source) {
+            if (!index) index.reset(new TrapezoidalMap(source));
+            const HalfEdge *h = f->rep;
+            return index->locate(Vertex((h->tail->x + h->head->x) / 2, (h->tail->y + h->head->y) / 2));
+        }
+
+    public:
+        DCEL dcel; /**< the overlay */
+        vector<Face *> faceA; /**< face of A containing each face of the overlay, by face id */
+        vector<Face *> faceB; /**< face of B containing each face of the overlay, by face id */
+
+        /**
+         * @brief Build the overlay of two DCELs
+         *
+         * @param a first DCEL
+         * @param b second DCEL
+         * @param threads number of threads used to split the edges, at least 1
+         */
+        MapOverlay(DCEL &a, DCEL &b, unsigned threads = 1): dcel(a, sourceA) {
+            vector<Edge> edges;
+            vector<HalfEdge *> halfEdges; // half-edge of the copy of A or of B of every edge
+            collect(dcel, edges, halfEdges);
+            unsigned long countA = edges.size();
+            collect(b, edges, halfEdges);
+            vector<unsigned long> source;
+            vector<Edge> split;
+            {
+                PROFILE_SCOPE("overlay split");
+                split = splitIntersections(edges, threads, &source);
+            }
+
+            PROFILE_SCOPE("overlay patch");
+            vector<vector<Vertex>> points(countA); // split points inside every edge of A
+            // pieces of B by their endpoints in (x, y) order, with their half-edges in that direction
+            map<pair<pair<double, double>, pair<double, double>>, vector<HalfEdge *>> piecesB;
+            for (unsigned long i = 0; i < split.size(); i++) {
+                const Vertex &p = split[i].src, &q = split[i].dst;
+                if (p == q) continue;
+                if (source[i] < countA) {
+                    const HalfEdge *h = halfEdges[source[i]];
+                    if (!(p == *h->tail) && !(p == *h->head)) points[source[i]].push_back(p);
+                    if (!(q == *h->tail) && !(q == *h->head)) points[source[i]].push_back(q);
+                    continue;
+                }
+                bool forward = lexLess(p.x, p.y, q.x, q.y);
+                const Vertex &u = forward ? p : q, &w = forward ? q : p;
+                HalfEdge *h = forward ? halfEdges[source[i]] : halfEdges[source[i]]->twin;
+                piecesB[make_pair(make_pair(u.x, u.y), make_pair(w.x, w.y))].push_back(h);
+            }
+            vector<Edge> added;
+            vector<HalfEdge *> addedFrom;
+            cutEdges(halfEdges, points, added, addedFrom);
+            addEdges(added, addedFrom, sourceA);
+
+            // the k-th copy of a piece of B around its tail is shared with the k-th copy of A,
+            // the other copies of B are added as new edges
+            added.clear();
+            addedFrom.clear();
+            for (auto &s: piecesB) {
+                vector<HalfEdge *> &copies = s.second;
+                starOrder(copies, b);
+                Vertex *u = dcel.getVertex(Vertex(s.first.first.first, s.first.first.second));
+                Vertex *w = dcel.getVertex(Vertex(s.first.second.first, s.first.second.second));
+                vector<HalfEdge *> shared;
+                if (u != nullptr && w != nullptr)
+                    for (HalfEdge *h: dcel.heMap[u])
+                        if (h->head == w && sourceA.count(h) != 0) shared.push_back(h);
+                for (unsigned long k = 0; k < copies.size(); k++) {
+                    if (k < shared.size()) {
+                        attach(shared[k], copies[k], sourceB);
+                        continue;
+                    }
+                    added.emplace_back(s.first.first.first, s.first.first.second, s.first.second.first, s.first.second.second);
+                    addedFrom.push_back(copies[k]);
+                }
+            }
+            addEdges(added, addedFrom, sourceB);
+
+            faceA.assign(dcel.faces.size(), nullptr);
+            faceB.assign(dcel.faces.size(), nullptr);
+            unique_ptr<TrapezoidalMap> indexA, indexB;
+            vector<signed char> flatA(a.faces.size(), -1), flatB(b.faces.size(), -1);
+            for (Face *f: dcel.faces) {
+                // a face holding a region does not come from a face of zero area
+                bool any = (measureFace(f).area == 0);
+                const HalfEdge *h = f->rep;
+                do {
+                    auto i = sourceA.find(h);
+                    if (i != sourceA.end() && (any || !flat(i->second->face, flatA))) faceA[f->id] = i->second->face;
+                    auto j = sourceB.find(h);
+                    if (j != sourceB.end() && (any || !flat(j->second->face, flatB))) faceB[f->id] = j->second->face;
+                    h = h->next;
+                } while (h != f->rep && (faceA[f->id] == nullptr || faceB[f->id] == nullptr));
+                if (faceA[f->id] == nullptr && !a.faces.empty()) faceA[f->id] = locateFace(f, indexA, a);
+                if (faceB[f->id] == nullptr && !b.faces.empty()) faceB[f->id] = locateFace(f, indexB, b);
+            }
+        }
+
+        MapOverlay(const MapOverlay &) = delete;
+        MapOverlay& operator=(const MapOverlay &) = delete;
+
+        /**
+         * @brief Faces of A and B a face of the overlay comes from
+         *
+         * @param f face of the overlay
+         * @return pair<Face *, Face *> face of A and face of B containing f
+         */
+        pair<Face *, Face *> sources(const Face *f) const {
+            return make_pair(faceA[f->id], faceB[f->id]);
+        }
+};
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * @file Parallel.h
+ * @brief This file contains small helpers to run loops and sorts over several threads
+ *
+ * The helpers split a range into one contiguous chunk per thread, run the first chunk on
+ * the calling thread and the others on std::thread workers, and return once all chunks
+ * are done. Programs using them may need to be compiled with <em>-pthread</em>.
+ */
+
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * @brief Number of threads supported by the hardware
+ *
+ * @return unsigned number of hardware threads, at least 1
+ */
+unsigned hardwareThreads() {
+    unsigned n = thread::hardware_concurrency();
+    return (n == 0) ? 1 : n;
+}
+
+/**
+ * @brief Split [begin, end) into contiguous chunks and process each chunk on its own thread
+ *
+ * Chunk t covers [begin + t * n / threads, begin + (t+1) * n / threads), so the split only
+ * depends on the size of the range and the number of threads.
+ *
+ * @tparam F callable taking (chunk number, chunk begin, chunk end)
+ * @param begin first index of the range
+ * @param end one past the last index of the range
+ * @param threads number of chunks (and threads) to use, at least 1
+ * @param f function called once for every chunk
+ */
+template <class F>
+void parallelChunks(unsigned long begin, unsigned long end, unsigned threads, F f) {
+    unsigned long n = end - begin;
+    if (threads < 1) threads = 1;
+    if (threads > n) threads = (n == 0) ? 1 : n;
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++)
+        workers.emplace_back(f, t, begin + t * n / threads, begin + (t + 1) * n / threads);
+    f(0u, begin, begin + n / threads);
+    for (thread &w: workers) w.join();
+}
+
+/**
+ * @brief Call a function for every index of [begin, end) using several threads
+ *
+ * Calls for different indices may run concurrently, so f must only write to data owned
+ * by its index.
+ *
+ * @tparam F callable taking an index
+ * @param begin first index of the range
+ * @param end one past the last index of the range
+ * @param threads number of threads to use, at least 1
+ * @param f function called once for every index
+ */
+template <class F>
+void parallelFor(unsigned long begin, unsigned long end, unsigned threads, F f) {
+    parallelChunks(begin, end, threads, [&f](unsigned, unsigned long lo, unsigned long hi) {
+        for (unsigned long i = lo; i < hi; i++) f(i);
+    });
+}
+
+/**
+ * @brief Sort a vector using several threads
+ *
+ * Each chunk is sorted on its own thread and sorted chunks are then merged pairwise, with
+ * the merges of one round running in parallel. Equal elements may be reordered, hence the
+ * comparator should be a strict total order when the result must be deterministic.
+ *
+ * @tparam T type of the elements
+ * @tparam Compare strict weak ordering over T
+ * @param v vector to be sorted
+ * @param comp comparator used to order the elements
+ * @param threads number of threads to use, at least 1
+ */
+template <class T, class Compare>
+void parallelSort(vector<T> &v, Compare comp, unsigned threads) {
+    if (threads < 1) threads = 1;
+    if (threads > v.size()) threads = (v.empty()) ? 1 : v.size();
+    vector<unsigned long> bound(threads + 1);
+    for (unsigned t = 0; t <= threads; t++) bound[t] = t * v.size() / threads;
+    parallelChunks(0, threads, threads, [&](unsigned, unsigned long lo, unsigned long hi) {
+        for (unsigned long t = lo; t < hi; t++) sort(v.begin() + bound[t], v.begin() + bound[t + 1], comp);
+    });
+    for (unsigned width = 1; width < threads; width *= 2) {
+        unsigned merges = (threads + 2 * width - 1) / (2 * width);
+        parallelFor(0, merges, merges, [&](unsigned long m) {
+            unsigned long lo = 2 * width * m, mid = min<unsigned long>(lo + width, threads);
+            unsigned long hi = min<unsigned long>(lo + 2 * width, threads);
+            if (mid < hi) inplace_merge(v.begin() + bound[lo], v.begin() + bound[mid], v.begin() + bound[hi], comp);
+        });
+    }
+}
+
+#endif
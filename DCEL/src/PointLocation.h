@@ -0,0 +1,392 @@
+/**
+ * @file PointLocation.h
+ * @brief This file contains a point location index answering which face of a DCEL contains a point
+ *
+ * The index is a trapezoidal map built by randomized incremental construction, as described
+ * in chapter 6 of "Computational Geometry: Algorithms and Applications" (de Berg et al.).
+ * The segments of the DCEL are inserted in random order and a search DAG records how each
+ * trapezoid was split. For any fixed set of segments the expected size of the map is O(n),
+ * its expected construction time is O(n log n) and a query takes O(log n) expected time.
+ */
+
+#ifndef __POINTLOCATION_H__
+#define __POINTLOCATION_H__
+
+#include <set>
+#include <random>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Geometry.h"
+#include "DCEL.h"
+#include "CompactDCEL.h"
+#include "Parallel.h"
+#include "Predicates.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @class TrapezoidalMap
+ * @brief Static point location index over the edges of a DCEL
+ *
+ * Instead of requiring distinct x coordinates, points are compared lexicographically by
+ * (x, y), which amounts to shearing the plane by an infinitesimal amount: a vertical
+ * segment goes from its lower endpoint (on the left) to its upper one (on the right) and
+ * the points above a segment are the ones to the left of it. Both tests are exact.
+ *
+ * The edges must not cross each other except at common endpoints. Zero length edges and
+ * repeated edges are ignored. The index keeps pointers to the half-edges of the DCEL and
+ * reads their faces when answering queries, so it must be rebuilt once edges are added or
+ * removed, while relabelling faces does not invalidate it. An index built over a
+ * CompactDCEL keeps half-edge indices instead and gives faces as indices with locateIndex().
+ */
+class TrapezoidalMap {
+    private:
+        /// Segment going from point p to point q, with p lexicographically smaller than q
+        struct Segment {
+            long p, q; /**< endpoints, as indices of the vertices of the DCEL */
+            double x1, y1, x2, y2; /**< coordinates of p and q, kept here to be read along with the segment */
+            HalfEdge *he; /**< half-edge going from p to q, its face lies above the segment, nullptr over a CompactDCEL */
+            uint32_t half; /**< index of that half-edge in the CompactDCEL, CompactDCEL::none over a DCEL */
+        };
+
+        /// Trapezoid bounded by two segments and the vertical lines through two points (-1 when unbounded)
+        struct Trapezoid {
+            long top, bottom; /**< segments above and below the trapezoid */
+            long leftp, rightp; /**< points defining the left and right sides */
+            long ul, ll; /**< neighbours across the left side, above and below leftp */
+            long ur, lr; /**< neighbours across the right side, above and below rightp */
+            long node; /**< leaf of the search DAG holding this trapezoid */
+        };
+
+        enum NodeType { XNODE, YNODE, LEAF };
+
+        /**
+         * @brief Node of the search DAG
+         *
+         * An x-node splits on a point: left holds what is lexicographically smaller. A y-node
+         * splits on a segment: left holds what lies above it. A leaf refers to a trapezoid.
+         */
+        struct Node {
+            NodeType type;
+            long index; /**< point, segment or trapezoid depending on type */
+            long left, right; /**< children of x-nodes and y-nodes */
+        };
+
+        vector<double> px, py; /**< coordinates of the vertices of the DCEL */
+        vector<Segment> segments; /**< segments of the map */
+        vector<Trapezoid> traps; /**< trapezoids of the map, including the ones split by later segments */
+        vector<Node> nodes; /**< search DAG, rooted at nodes[0] */
+        unsigned long split; /**< number of trapezoids split by later segments */
+        const CompactDCEL *compact; /**< CompactDCEL the index is built over, nullptr over a DCEL */
+
+        /// true if point a is lexicographically smaller than point b
+        bool lexLess(long a, long b) const {
+            return px[a] < px[b] || (px[a] == px[b] && py[a] < py[b]);
+        }
+
+        /// Orientation of point c with respect to segment s: +1 above, -1 below, 0 on its line
+        int side(long s, double cx, double cy) const {
+            const Segment &seg = segments[s];
+            return orientExact(seg.x1, seg.y1, seg.x2, seg.y2, cx, cy);
+        }
+
+        /**
+         * @brief Whether segment s lies above segment t where their x ranges overlap
+         *
+         * The segments must not cross and must overlap on more than a single point.
+         */
+        bool above(long s, long t) const {
+            const Segment &a = segments[s], &b = segments[t];
+            if (a.p == b.p) return side(t, px[a.q], py[a.q]) > 0;
+            if (a.q == b.q) return side(t, px[a.p], py[a.p]) > 0;
+            if (lexLess(b.p, a.p)) return side(t, px[a.p], py[a.p]) > 0;
+            return side(s, px[b.p], py[b.p]) < 0;
+        }
+
+        /// Add a trapezoid along with its leaf in the search DAG
+        long newTrapezoid(long top, long bottom, long leftp, long rightp) {
+            traps.push_back({top, bottom, leftp, rightp, -1, -1, -1, -1, (long) nodes.size()});
+            nodes.push_back({LEAF, (long) traps.size() - 1, -1, -1});
+            return traps.size() - 1;
+        }
+
+        /// Add an inner node to the search DAG
+        long newNode(NodeType type, long index, long left, long right) {
+            nodes.push_back({type, index, left, right});
+            return nodes.size() - 1;
+        }
+
+        /**
+         * @brief Find the trapezoid containing the points of segment s just right of point r
+         *
+         * @param s segment not yet in the map
+         * @param r point of s or vertex whose vertical line crosses s
+         * @return long trapezoid entered by s when it crosses the vertical line through r
+         */
+        long locateAlong(long s, long r) const {
+            long n = 0;
+            while (nodes[n].type != LEAF) {
+                const Node &node = nodes[n];
+                if (node.type == XNODE) n = lexLess(r, node.index) ? node.left : node.right;
+                else n = above(s, node.index) ? node.left : node.right;
+            }
+            return nodes[n].index;
+        }
+
+        /// Make the trapezoid t left of a wall refer to a above and b below its right point instead of old
+        void replaceRight(long t, long old, long a, long b) {
+            if (t == -1) return;
+            if (traps[t].ur == old) traps[t].ur = a;
+            if (traps[t].lr == old) traps[t].lr = b;
+        }
+
+        /// Make the trapezoid t right of a wall refer to a above and b below its left point instead of old
+        void replaceLeft(long t, long old, long a, long b) {
+            if (t == -1) return;
+            if (traps[t].ul == old) traps[t].ul = a;
+            if (traps[t].ll == old) traps[t].ll = b;
+        }
+
+        /// Trapezoid containing point v, found with the search DAG
+        const Trapezoid& trapezoidAt(const Vertex &v) const {
+            long n = 0;
+            while (nodes[n].type != LEAF) {
+                const Node &node = nodes[n];
+                if (node.type == XNODE) n = (v.x < px[node.index] || (v.x == px[node.index] && v.y < py[node.index])) ? node.left : node.right;
+                else n = (side(node.index, v.x, v.y) >= 0) ? node.left : node.right;
+            }
+            return traps[nodes[n].index];
+        }
+
+        /// Insert the segments in an order given by the seed
+        void build(unsigned long seed) {
+            mt19937_64 rng(seed);
+            shuffle(segments.begin(), segments.end(), rng);
+
+            traps.reserve(4 * segments.size() + 1);
+            nodes.reserve(8 * segments.size() + 1);
+            newTrapezoid(-1, -1, -1, -1);
+            for (unsigned long s = 0; s < segments.size(); s++) insert(s);
+        }
+
+        /**
+         * @brief Insert a segment, splitting the trapezoids it crosses
+         *
+         * The trapezoid containing the left end of s is found with the DAG, the next ones by
+         * walking to the right neighbour below (above) the right point of the current one when
+         * that point lies above (below) s. Each of them is split into a part above and a part
+         * below s. Consecutive parts are merged unless the vertical line between them, which
+         * used to cross s, still ends on their side of s.
+         */
+        void insert(long s) {
+            long p = segments[s].p, q = segments[s].q;
+            vector<long> crossed(1, locateAlong(s, p));
+            for (long r = traps[crossed.back()].rightp; r != -1 && lexLess(r, q); r = traps[crossed.back()].rightp) {
+                long t = (side(s, px[r], py[r]) > 0) ? traps[crossed.back()].lr : traps[crossed.back()].ur;
+                if (t == -1) break; // only happens when s crosses another segment
+                crossed.push_back(t);
+            }
+
+            split += crossed.size();
+            long upper = -1, lower = -1;
+            for (unsigned long j = 0; j < crossed.size(); j++) {
+                long c = crossed[j], left = -1, right = -1;
+                Trapezoid d = traps[c];
+                if (j == 0) {
+                    upper = newTrapezoid(d.top, s, p, -1);
+                    lower = newTrapezoid(s, d.bottom, p, -1);
+                    if (d.leftp != p) {
+                        left = newTrapezoid(d.top, d.bottom, d.leftp, p);
+                        traps[left].ul = d.ul;
+                        traps[left].ll = d.ll;
+                        traps[left].ur = upper;
+                        traps[left].lr = lower;
+                        replaceRight(d.ul, c, left, left);
+                        replaceRight(d.ll, c, left, left);
+                        traps[upper].ul = traps[lower].ll = left;
+                    }
+                    else {
+                        traps[upper].ul = d.ul;
+                        traps[lower].ll = d.ll;
+                        replaceRight(d.ul, c, upper, lower);
+                        replaceRight(d.ll, c, upper, lower);
+                    }
+                }
+                else {
+                    long prev = crossed[j - 1], r = traps[prev].rightp;
+                    if (side(s, px[r], py[r]) > 0) {
+                        long next = newTrapezoid(d.top, s, r, -1);
+                        traps[upper].rightp = r;
+                        traps[upper].ur = traps[prev].ur;
+                        traps[upper].lr = next;
+                        replaceLeft(traps[prev].ur, prev, upper, upper);
+                        traps[next].ul = d.ul;
+                        traps[next].ll = upper;
+                        replaceRight(d.ul, c, next, next);
+                        upper = next;
+                    }
+                    else {
+                        long next = newTrapezoid(s, d.bottom, r, -1);
+                        traps[lower].rightp = r;
+                        traps[lower].lr = traps[prev].lr;
+                        traps[lower].ur = next;
+                        replaceLeft(traps[prev].lr, prev, lower, lower);
+                        traps[next].ll = d.ll;
+                        traps[next].ul = lower;
+                        replaceRight(d.ll, c, next, next);
+                        lower = next;
+                    }
+                }
+                if (j + 1 == crossed.size()) {
+                    if (d.rightp != q) {
+                        right = newTrapezoid(d.top, d.bottom, q, d.rightp);
+                        traps[right].ur = d.ur;
+                        traps[right].lr = d.lr;
+                        traps[right].ul = upper;
+                        traps[right].ll = lower;
+                        replaceLeft(d.ur, c, right, right);
+                        replaceLeft(d.lr, c, right, right);
+                        traps[upper].ur = traps[lower].lr = right;
+                    }
+                    else {
+                        traps[upper].ur = d.ur;
+                        traps[lower].lr = d.lr;
+                        replaceLeft(d.ur, c, upper, lower);
+                        replaceLeft(d.lr, c, upper, lower);
+                    }
+                }
+
+                // the leaf of d is replaced in place so that every parent now reaches the new trapezoids
+                Node sub = {YNODE, s, traps[upper].node, traps[lower].node};
+                if (right != -1) sub = {XNODE, q, newNode(sub.type, sub.index, sub.left, sub.right), traps[right].node};
+                if (left != -1) sub = {XNODE, p, traps[left].node, newNode(sub.type, sub.index, sub.left, sub.right)};
+                nodes[d.node] = sub;
+            }
+            traps[upper].rightp = q;
+            traps[lower].rightp = q;
+        }
+
+    public:
+        /**
+         * @brief Build the point location index of a DCEL
+         *
+         * @param dcel DCEL whose faces are located, it must outlive the index
+         * @param seed seed of the random insertion order, the map only depends on it and on the DCEL
+         */
+        TrapezoidalMap(DCEL &dcel, unsigned long seed = 1): split(0), compact(nullptr) {
+            PROFILE_SCOPE("point location build");
+            unordered_map<const Vertex *, long> index;
+            index.reserve(dcel.vertices.size());
+            for (Vertex *v: dcel.vertices) {
+                index[v] = px.size();
+                px.push_back(v->x);
+                py.push_back(v->y);
+            }
+            set<pair<long, long>> seen;
+            for (Vertex *v: dcel.vertices) {
+                for (HalfEdge *he: dcel.heMap[v]) {
+                    long a = index[he->tail], b = index[he->head];
+                    if (lexLess(a, b) && seen.insert(make_pair(a, b)).second)
+                        segments.push_back({a, b, px[a], py[a], px[b], py[b], he, CompactDCEL::none});
+                }
+            }
+            build(seed);
+        }
+
+        /**
+         * @brief Build the point location index of a CompactDCEL
+         *
+         * Faces are then located with locateIndex() only.
+         *
+         * @param dcel CompactDCEL whose faces are located, it must outlive the index
+         * @param seed seed of the random insertion order, the map only depends on it and on the DCEL
+         */
+        TrapezoidalMap(const CompactDCEL &dcel, unsigned long seed = 1): px(dcel.x), py(dcel.y), split(0), compact(&dcel) {
+            PROFILE_SCOPE("point location build");
+            set<pair<long, long>> seen;
+            for (uint32_t h = 0; h < dcel.numHalfEdges(); h++) {
+                long a = dcel.tail(h), b = dcel.head(h);
+                if (lexLess(a, b) && seen.insert(make_pair(a, b)).second)
+                    segments.push_back({a, b, px[a], py[a], px[b], py[b], nullptr, h});
+            }
+            build(seed);
+        }
+
+        /**
+         * @brief Find the face containing a point
+         *
+         * The face is read from the segment right above the point, or right below when there
+         * is none. Outside of every bounded face this gives the outer face of the nearest
+         * component. A point lying on an edge or a vertex gets one of the faces around it.
+         *
+         * @param v point to be located
+         * @return Face* face containing v, nullptr if the DCEL has no edge above nor below v
+         */
+        Face* locate(const Vertex &v) const {
+            const Trapezoid &t = trapezoidAt(v);
+            if (t.top != -1) return segments[t.top].he->twin->face;
+            if (t.bottom != -1) return segments[t.bottom].he->face;
+            return nullptr;
+        }
+
+        /**
+         * @brief Find the face of the CompactDCEL containing a point
+         *
+         * Same as locate(), for an index built over a CompactDCEL.
+         *
+         * @param v point to be located
+         * @return uint32_t index of the face containing v, CompactDCEL::none if there is no edge above nor below v
+         */
+        uint32_t locateIndex(const Vertex &v) const {
+            const Trapezoid &t = trapezoidAt(v);
+            if (t.top != -1) return compact->face[CompactDCEL::twin(segments[t.top].half)];
+            if (t.bottom != -1) return compact->face[segments[t.bottom].half];
+            return CompactDCEL::none;
+        }
+
+        /**
+         * @brief Find the bounded face containing a point, holes included
+         *
+         * Same as locate(), except that a point lying between the cycles of an island and
+         * the boundary of the face around it gets that face rather than the outer cycle of
+         * the island. Needs the links set by findHoles() (Holes.h).
+         *
+         * @param v point to be located
+         * @return Face* bounded face containing v, nullptr in the unbounded face
+         */
+        Face* locateRegion(const Vertex &v) const {
+            Face *f = locate(v);
+            return (f == nullptr) ? nullptr : f->outer;
+        }
+
+        /**
+         * @brief Locate many points using several threads
+         *
+         * @param points points to be located
+         * @param threads number of threads to use, at least 1
+         * @return vector<Face*> face containing each point, as given by locate()
+         */
+        vector<Face*> locate(const vector<Vertex> &points, unsigned threads) const {
+            PROFILE_SCOPE("point location query");
+            vector<Face*> result(points.size());
+            parallelFor(0, points.size(), threads, [&](unsigned long i) {
+                result[i] = locate(points[i]);
+            });
+            return result;
+        }
+
+        /**
+         * @brief Number of trapezoids in the map
+         *
+         * @return unsigned long number of trapezoids, O(n) in expectation for n segments
+         */
+        unsigned long size() const {
+            return traps.size() - split;
+        }
+};
+
+#endif
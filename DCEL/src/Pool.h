@@ -0,0 +1,156 @@
+/**
+ * @file Pool.h
+ * @brief This file contains the pool allocators used for the objects of the DCEL
+ *
+ * Allocating every Vertex, HalfEdge and Face with its own new scatters them over the heap
+ * and makes destroying a DCEL cost one delete per object. A Pool hands out objects from
+ * large blocks instead, recycles the objects given back to it and frees all its blocks at
+ * once. A DCELArena groups one pool per object type and can be shared by many DCELs.
+ */
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <new>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include "Geometry.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @class Pool
+ * @brief Block based pool allocator for objects of type T
+ *
+ * Objects are constructed in place inside blocks of blockSize objects, so objects created
+ * one after the other are also next to each other in memory. Destroyed objects are kept in
+ * a free list and reused by the next create(). Since T must be trivially destructible,
+ * clear() releases every object with one deallocation per block.
+ *
+ * @tparam T type of the objects stored in the pool
+ */
+template <class T>
+class Pool {
+    static_assert(is_trivially_destructible<T>::value, "Pool can only hold trivially destructible objects");
+
+    private:
+        static const unsigned long blockSize = 4096; /**< number of objects in each block */
+        vector<T *> blocks; /**< allocated blocks, only the last one can be partially used */
+        unsigned long used; /**< number of objects handed out from the last block */
+        vector<T *> freed; /**< destroyed objects waiting to be reused */
+
+    public:
+        /**
+         * @brief Construct a new empty Pool object
+         *
+         */
+        Pool(): used(blockSize) {}
+
+        Pool(const Pool &) = delete;
+        Pool& operator=(const Pool &) = delete;
+
+        /**
+         * @brief Reserve the storage of one object without constructing it
+         *
+         * The returned object must be constructed with placement new before it is used. This
+         * lets objects be reserved on one thread and constructed in parallel on others.
+         *
+         * @return T* pointer to uninitialized storage for one object
+         */
+        T* allocate() {
+            T *p;
+            if (!freed.empty()) {
+                p = freed.back();
+                freed.pop_back();
+            }
+            else {
+                if (used == blockSize) {
+                    PROFILE_COUNT(ALLOCATIONS);
+                    blocks.push_back(static_cast<T *>(::operator new(blockSize * sizeof(T))));
+                    used = 0;
+                }
+                p = blocks.back() + used++;
+            }
+            return p;
+        }
+
+        /**
+         * @brief Construct a new object in the pool
+         *
+         * @param args arguments passed to the constructor of T
+         * @return T* pointer to the new object, valid until it is destroyed or the pool is cleared
+         */
+        template <class... Args>
+        T* create(Args&&... args) {
+            return new (allocate()) T(forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Give an object back to the pool so that its memory is reused
+         *
+         * @param p pointer to an object created by this pool
+         */
+        void destroy(T *p) {
+            freed.push_back(p);
+        }
+
+        /**
+         * @brief Number of objects currently alive in the pool
+         *
+         * @return unsigned long number of created objects which were not destroyed
+         */
+        unsigned long size() const {
+            return blocks.empty() ? 0 : (blocks.size() - 1) * blockSize + used - freed.size();
+        }
+
+        /**
+         * @brief Release every object of the pool at once
+         *
+         * All pointers handed out by this pool become invalid.
+         */
+        void clear() {
+            for (T *b: blocks) ::operator delete(b);
+            blocks.clear();
+            freed.clear();
+            used = blockSize;
+        }
+
+        /**
+         * @brief Destroy the Pool object, releasing all its objects
+         *
+         */
+        ~Pool() {
+            clear();
+        }
+};
+
+/**
+ * @class DCELArena
+ * @brief The pools holding the Vertex, HalfEdge and Face objects of one or more DCELs
+ *
+ * By default a DCEL creates its own arena and releases it when destroyed. An arena can
+ * also be passed to the DCEL constructors, in which case the DCEL does not free its objects
+ * and many DCELs can be discarded together with a single reset() of the arena.
+ */
+class DCELArena {
+    public:
+        Pool<Vertex> vertices; /**< pool of Vertex objects */
+        Pool<HalfEdge> halfEdges; /**< pool of HalfEdge objects */
+        Pool<Face> faces; /**< pool of Face objects */
+
+        /**
+         * @brief Release every object created in this arena
+         *
+         * All DCELs built over this arena become invalid and must not be used anymore.
+         */
+        void reset() {
+            vertices.clear();
+            halfEdges.clear();
+            faces.clear();
+        }
+};
+
+#endif
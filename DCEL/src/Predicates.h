@@ -0,0 +1,223 @@
+/**
+ * @file Predicates.h
+ * @brief This file contains exact geometric predicates and the angular order of half-edges
+ *
+ * The predicates first evaluate their determinant in plain double arithmetic and only fall
+ * back to exact arithmetic when the result is too close to zero for its sign to be trusted.
+ * The exact path represents numbers as expansions (sums of non overlapping doubles) as
+ * described by J. R. Shewchuk in "Adaptive Precision Floating-Point Arithmetic and Fast
+ * Robust Geometric Predicates". Inputs are assumed to be finite and not to underflow.
+ */
+
+#ifndef __PREDICATES_H__
+#define __PREDICATES_H__
+
+#include <cmath>
+#include "Profiler.h"
+
+using namespace std;
+
+const double predicateEpsilon = 1.1102230246251565e-16; /**< 2^-53, half a unit in the last place of 1.0 */
+const double orientErrorBound = (3.0 + 16.0 * predicateEpsilon) * predicateEpsilon; /**< relative error bound of the filtered determinant */
+
+/// Exact sum: x + y == a + b where x is the rounded sum
+void twoSum(double a, double b, double &x, double &y) {
+    x = a + b;
+    double bv = x - a, av = x - bv;
+    y = (a - av) + (b - bv);
+}
+
+/// Exact sum when |a| >= |b|: x + y == a + b where x is the rounded sum
+void fastTwoSum(double a, double b, double &x, double &y) {
+    x = a + b;
+    y = b - (x - a);
+}
+
+/// Exact difference: x + y == a - b where x is the rounded difference
+void twoDiff(double a, double b, double &x, double &y) {
+    x = a - b;
+    double bv = a - x, av = x + bv;
+    y = (a - av) + (bv - b);
+}
+
+/// Exact product: x + y == a * b where x is the rounded product
+void twoProduct(double a, double b, double &x, double &y) {
+    x = a * b;
+    y = fma(a, b, -x);
+}
+
+/**
+ * @brief Add a double to an expansion, dropping zero components
+ *
+ * @param elen number of components of e
+ * @param e expansion in increasing order of magnitude
+ * @param b double to be added
+ * @param h output expansion, with room for elen + 1 components (must not be e)
+ * @return int number of components of h
+ */
+int growExpansion(int elen, const double *e, double b, double *h) {
+    int hlen = 0;
+    double q = b, t;
+    for (int i = 0; i < elen; i++) {
+        twoSum(q, e[i], q, t);
+        if (t != 0) h[hlen++] = t;
+    }
+    if (q != 0 || hlen == 0) h[hlen++] = q;
+    return hlen;
+}
+
+/**
+ * @brief Multiply an expansion by a double, dropping zero components
+ *
+ * @param elen number of components of e
+ * @param e expansion in increasing order of magnitude
+ * @param b double to multiply with
+ * @param h output expansion, with room for 2 * elen components (must not be e)
+ * @return int number of components of h
+ */
+int scaleExpansion(int elen, const double *e, double b, double *h) {
+    int hlen = 0;
+    double q, t, hi, lo, sum;
+    twoProduct(e[0], b, q, t);
+    if (t != 0) h[hlen++] = t;
+    for (int i = 1; i < elen; i++) {
+        twoProduct(e[i], b, hi, lo);
+        twoSum(q, lo, sum, t);
+        if (t != 0) h[hlen++] = t;
+        fastTwoSum(hi, sum, q, t);
+        if (t != 0) h[hlen++] = t;
+    }
+    if (q != 0 || hlen == 0) h[hlen++] = q;
+    return hlen;
+}
+
+/**
+ * @brief Add two expansions
+ *
+ * @param elen number of components of e
+ * @param e expansion in increasing order of magnitude
+ * @param flen number of components of f
+ * @param f expansion in increasing order of magnitude
+ * @param h output expansion, with room for elen + flen components
+ * @return int number of components of h
+ */
+int sumExpansion(int elen, const double *e, int flen, const double *f, double *h) {
+    double buffer[2][32];
+    int len = elen, cur = 0;
+    for (int i = 0; i < elen; i++) buffer[0][i] = e[i];
+    for (int j = 0; j < flen; j++) {
+        len = growExpansion(len, buffer[cur], f[j], buffer[1 - cur]);
+        cur = 1 - cur;
+    }
+    for (int i = 0; i < len; i++) h[i] = buffer[cur][i];
+    return len;
+}
+
+/// Sign of a double: -1, 0 or +1
+int sign(double x) {
+    return (x > 0) - (x < 0);
+}
+
+/**
+ * @brief Exact sign of the cross product of (ax, ay) and (bx, by)
+ *
+ * @return int +1 if b is counter clockwise from a, -1 if clockwise, 0 if they are parallel
+ */
+int crossSign(double ax, double ay, double bx, double by) {
+    double left = ax * by, right = ay * bx, det = left - right;
+    if (abs(det) > orientErrorBound * (abs(left) + abs(right))) return sign(det);
+    double l[2], r[2], d[4];
+    twoProduct(ax, by, l[1], l[0]);
+    twoProduct(-ay, bx, r[1], r[0]);
+    int dlen = sumExpansion(2, l, 2, r, d);
+    return sign(d[dlen - 1]);
+}
+
+/**
+ * @brief Exact orientation of three points
+ *
+ * @return int +1 if a, b, c turn counter clockwise, -1 if clockwise and 0 if they are collinear
+ */
+int orientExact(double ax, double ay, double bx, double by, double cx, double cy) {
+    PROFILE_COUNT(ORIENT_CALLS);
+    double left = (ax - cx) * (by - cy), right = (ay - cy) * (bx - cx), det = left - right;
+    if (abs(det) > orientErrorBound * (abs(left) + abs(right))) return sign(det);
+    double acx[2], bcy[2], acy[2], bcx[2], s1[4], s2[4], l[8], r[8], d[16];
+    twoDiff(ax, cx, acx[1], acx[0]);
+    twoDiff(by, cy, bcy[1], bcy[0]);
+    twoDiff(cy, ay, acy[1], acy[0]); // negated so that the right term is subtracted
+    twoDiff(bx, cx, bcx[1], bcx[0]);
+    int llen = sumExpansion(scaleExpansion(2, acx, bcy[0], s1), s1, scaleExpansion(2, acx, bcy[1], s2), s2, l);
+    int rlen = sumExpansion(scaleExpansion(2, acy, bcx[0], s1), s1, scaleExpansion(2, acy, bcx[1], s2), s2, r);
+    int dlen = sumExpansion(llen, l, rlen, r, d);
+    return sign(d[dlen - 1]);
+}
+
+/**
+ * @class StarKey
+ * @brief Precomputed key giving the clockwise order of the half-edges leaving a vertex
+ *
+ * Half-edges leaving a vertex are ordered by decreasing angle of their direction, angles
+ * being taken in (-pi, pi] from the positive x axis. Instead of computing the angle, the
+ * direction is first classified by half plane: the upper half (angles in (0, pi]) comes
+ * before the lower half (angles in (-pi, 0]). Within a half plane two directions differ by
+ * less than pi, so their order is the sign of their cross product, which is evaluated
+ * exactly. A zero length direction is ordered as the positive x axis (angle 0).
+ */
+class StarKey {
+    public:
+        double tx, ty; /**< tail of the half-edge */
+        double hx, hy; /**< head of the half-edge */
+        double dx, dy; /**< direction of the half-edge, head - tail rounded to doubles */
+        int half; /**< 0 for the upper half plane, 1 for the lower one */
+        bool exact; /**< true if dx and dy are exact, so the cross product can use them directly */
+
+        /**
+         * @brief Construct a new empty StarKey object
+         *
+         */
+        StarKey() {}
+
+        /**
+         * @brief Construct the key of the half-edge going from (X1, Y1) to (X2, Y2)
+         *
+         */
+        StarKey(double X1, double Y1, double X2, double Y2): tx(X1), ty(Y1), hx(X2), hy(Y2) {
+            double ex, ey;
+            twoDiff(hx, tx, dx, ex);
+            twoDiff(hy, ty, dy, ey);
+            exact = (ex == 0 && ey == 0);
+            half = (hy > ty || (hy == ty && hx < tx)) ? 0 : 1;
+        }
+
+        /// true if the direction has zero length
+        bool zero() const {
+            return hx == tx && hy == ty;
+        }
+};
+
+/**
+ * @brief Exact sign of the cross product of the directions of two keys with the same tail
+ *
+ * @return int +1 if q is counter clockwise from p, -1 if clockwise, 0 if they are parallel
+ */
+int crossSign(const StarKey &p, const StarKey &q) {
+    if (p.zero()) return q.zero() ? 0 : sign(q.hy - q.ty); // cross((1, 0), q)
+    if (q.zero()) return -sign(p.hy - p.ty);               // cross(p, (1, 0))
+    if (p.exact && q.exact) return crossSign(p.dx, p.dy, q.dx, q.dy);
+    return orientExact(p.tx, p.ty, p.hx, p.hy, q.hx, q.hy);
+}
+
+/**
+ * @brief Strict weak ordering of the half-edges leaving a vertex in clockwise order
+ *
+ * @param p key of the first half-edge
+ * @param q key of the second half-edge, with the same tail as p
+ * @return true if p has a strictly larger angle than q
+ */
+bool starBefore(const StarKey &p, const StarKey &q) {
+    if (p.half != q.half) return p.half < q.half;
+    return crossSign(p, q) < 0;
+}
+
+#endif
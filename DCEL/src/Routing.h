@@ -0,0 +1,608 @@
+/**
+ * @file Routing.h
+ * @brief This file contains shortest path queries over the roads of a DCEL
+ *
+ * The vertices and edges of a road network form a graph whose edges are weighted by their
+ * length. Router answers shortest path queries on it with a bidirectional Dijkstra search,
+ * and after an optional contraction hierarchy preprocessing with a search that only climbs
+ * the hierarchy. Batches of sources and targets give a table of distances.
+ */
+
+#ifndef __ROUTING_H__
+#define __ROUTING_H__
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Geometry.h"
+#include "DCEL.h"
+#include "GraphExport.h"
+#include "Parallel.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @class DistanceHeap
+ * @brief Binary min heap of nodes keyed by distance, with decrease-key
+ *
+ * The heap is a single array of (distance, node) pairs, and the position of every node in
+ * it is kept in an array indexed by node, so that a node already in the heap is moved up
+ * in place when its distance decreases.
+ */
+class DistanceHeap {
+    private:
+        vector<pair<double, uint32_t>> heap; /**< (distance, node), smallest distance first */
+        vector<uint32_t> position; /**< index of each node in heap, NONE if absent */
+
+        /// Move the entry at index i up to its place and update the positions
+        void siftUp(unsigned long i) {
+            pair<double, uint32_t> e = heap[i];
+            while (i > 0) {
+                unsigned long p = (i - 1) / 2;
+                if (heap[p].first <= e.first) break;
+                heap[i] = heap[p];
+                position[heap[i].second] = i;
+                i = p;
+            }
+            heap[i] = e;
+            position[e.second] = i;
+        }
+
+        /// Move the entry at index i down to its place and update the positions
+        void siftDown(unsigned long i) {
+            pair<double, uint32_t> e = heap[i];
+            unsigned long n = heap.size();
+            while (2 * i + 1 < n) {
+                unsigned long c = 2 * i + 1;
+                if (c + 1 < n && heap[c + 1].first < heap[c].first) c++;
+                if (e.first <= heap[c].first) break;
+                heap[i] = heap[c];
+                position[heap[i].second] = i;
+                i = c;
+            }
+            heap[i] = e;
+            position[e.second] = i;
+        }
+
+    public:
+        static const uint32_t NONE = numeric_limits<uint32_t>::max();
+
+        /**
+         * @brief Construct a new empty DistanceHeap object
+         *
+         * @param n number of nodes, which are numbered 0 ... n-1
+         */
+        DistanceHeap(uint32_t n = 0): position(n, NONE) {}
+
+        bool empty() const { return heap.empty(); }
+
+        /// Smallest distance in the heap, infinity if it is empty
+        double minKey() const { return heap.empty() ? numeric_limits<double>::infinity() : heap[0].first; }
+
+        /**
+         * @brief Insert a node, or lower its distance if it is already in the heap
+         *
+         * @param v node
+         * @param d new distance of v, not larger than its current one
+         */
+        void push(uint32_t v, double d) {
+            if (position[v] == NONE) {
+                heap.emplace_back(d, v);
+                siftUp(heap.size() - 1);
+            }
+            else {
+                heap[position[v]].first = d;
+                siftUp(position[v]);
+            }
+        }
+
+        /// Remove and return the node with the smallest distance
+        uint32_t pop() {
+            uint32_t v = heap[0].second;
+            position[v] = NONE;
+            pair<double, uint32_t> last = heap.back();
+            heap.pop_back();
+            if (!heap.empty()) {
+                heap[0] = last;
+                siftDown(0);
+            }
+            return v;
+        }
+
+        /// Remove all nodes, in time proportional to their number
+        void clear() {
+            for (const pair<double, uint32_t> &e: heap) position[e.second] = NONE;
+            heap.clear();
+        }
+};
+
+/**
+ * @class SearchSpace
+ * @brief Distances and parents of one Dijkstra search, reusable across searches
+ *
+ * The arrays cover every node, but only the nodes reached are reset before the next
+ * search, so a short search costs no more than the part of the graph it visits.
+ */
+class SearchSpace {
+    public:
+        vector<double> dist; /**< tentative distance of each node, infinity if not reached */
+        vector<uint32_t> parent; /**< previous node on the path to each node */
+        vector<uint32_t> reached; /**< nodes with a finite distance */
+        DistanceHeap heap; /**< nodes reached but not settled */
+
+        /**
+         * @brief Construct a new SearchSpace object
+         *
+         * @param n number of nodes of the graph
+         */
+        SearchSpace(uint32_t n = 0): dist(n, numeric_limits<double>::infinity()), parent(n, DistanceHeap::NONE), heap(n) {}
+
+        /// Forget the previous search
+        void reset() {
+            for (uint32_t v: reached) {
+                dist[v] = numeric_limits<double>::infinity();
+                parent[v] = DistanceHeap::NONE;
+            }
+            reached.clear();
+            heap.clear();
+        }
+
+        /**
+         * @brief Reach a node with a distance, if it is shorter than its current one
+         *
+         * @param v node reached
+         * @param d distance of the path to v
+         * @param p previous node on that path
+         * @return true if the distance of v decreased
+         */
+        bool relax(uint32_t v, double d, uint32_t p) {
+            if (d >= dist[v]) return false;
+            if (dist[v] == numeric_limits<double>::infinity()) reached.push_back(v);
+            dist[v] = d;
+            parent[v] = p;
+            heap.push(v, d);
+            return true;
+        }
+};
+
+/**
+ * @class Router
+ * @brief Shortest paths between the vertices of a DCEL, weighted by edge length
+ *
+ * Node i is dcel.vertices[i], and the edges come from primalGraph(). Queries run a
+ * bidirectional Dijkstra search, which grows a search from both ends, always on the side
+ * with the smaller next distance, and stops once the two next distances add up to at
+ * least the best path found.
+ *
+ * contract() builds a contraction hierarchy. Nodes are removed one by one, the least
+ * important first (by twice the number of shortcuts their removal adds minus their degree,
+ * plus the number of neighbours already removed and their depth in the hierarchy, which
+ * spreads the removals evenly over the network). Removing v adds a shortcut u-w of length
+ * |uv| + |vw| between two remaining neighbours unless a local witness search finds a path
+ * from u to w at most as long that avoids v. Every shortest path then goes up the order of
+ * removal and down again, so both searches only follow edges to nodes removed later, and
+ * skip the nodes reached more quickly through a higher node. Shortcuts remember the node
+ * they skip and are expanded into roads when a path is asked for.
+ *
+ * The Router keeps its own copy of the graph, so edits of the DCEL need a new Router.
+ * Single queries reuse the search spaces of the Router and must not run concurrently; the
+ * batch functions give every thread its own.
+ */
+class Router {
+    private:
+        static const uint32_t NONE = DistanceHeap::NONE;
+
+        /// Edge of the hierarchy, from a node to one removed later
+        struct Arc {
+            uint32_t to; /**< node at the other end */
+            uint32_t middle; /**< node skipped by the shortcut, NONE for a road */
+            double weight; /**< length */
+        };
+
+        CSRGraph graph; /**< roads, see primalGraph() */
+        vector<const Vertex *> vertexOf; /**< vertex of each node */
+        unordered_map<const Vertex *, uint32_t> ids; /**< node of each vertex */
+        SearchSpace forward, backward; /**< search spaces of single queries */
+
+        vector<uint32_t> rank; /**< position of each node in the order of removal, empty before contract() */
+        vector<uint32_t> upOffsets; /**< arcs of node v are up[upOffsets[v]] ... up[upOffsets[v+1]-1] */
+        vector<Arc> up; /**< edges and shortcuts to nodes removed later */
+
+        /**
+         * @brief Witness search of the contraction, from u in the remaining graph without v
+         *
+         * The search stops after settling 100 nodes, in which case a shortcut may be added
+         * although a witness exists, which only costs some query time.
+         *
+         * @param adj remaining edges and shortcuts
+         * @param space search space, reset here
+         * @param u source
+         * @param v node being removed
+         * @param limit largest distance of interest
+         */
+        static void witness(const vector<vector<Arc>> &adj, SearchSpace &space, uint32_t u, uint32_t v, double limit) {
+            space.reset();
+            space.relax(u, 0, NONE);
+            for (unsigned settled = 0; !space.heap.empty() && settled < 100; settled++) {
+                double d = space.heap.minKey();
+                if (d > limit) break;
+                uint32_t x = space.heap.pop();
+                for (const Arc &a: adj[x])
+                    if (a.to != v) space.relax(a.to, d + a.weight, x);
+            }
+        }
+
+        /**
+         * @brief Shortcuts needed to remove a node
+         *
+         * @param adj remaining edges and shortcuts
+         * @param space search space for the witness searches
+         * @param v node to be removed
+         * @param shortcuts if not nullptr, receives the shortcuts as (u, Arc to w) pairs, each once
+         * @return int number of shortcuts minus the number of remaining neighbours of v
+         */
+        static int simulate(const vector<vector<Arc>> &adj, SearchSpace &space, uint32_t v, vector<pair<uint32_t, Arc>> *shortcuts) {
+            const vector<Arc> &around = adj[v];
+            int added = 0;
+            for (unsigned long i = 0; i + 1 < around.size(); i++) {
+                uint32_t u = around[i].to;
+                double limit = 0;
+                for (unsigned long j = i + 1; j < around.size(); j++)
+                    limit = max(limit, around[i].weight + around[j].weight);
+                witness(adj, space, u, v, limit);
+                for (unsigned long j = i + 1; j < around.size(); j++) {
+                    uint32_t w = around[j].to;
+                    double through = around[i].weight + around[j].weight;
+                    if (space.dist[w] <= through) continue;
+                    added++;
+                    if (shortcuts != nullptr) shortcuts->push_back(make_pair(u, Arc{w, v, through}));
+                }
+            }
+            return added - (int)around.size();
+        }
+
+        /// Add an arc to a list of arcs, or shorten the arc of the list going to the same node
+        static void addArc(vector<Arc> &arcs, const Arc &a) {
+            for (Arc &b: arcs) {
+                if (b.to != a.to) continue;
+                if (a.weight < b.weight) b = a;
+                return;
+            }
+            arcs.push_back(a);
+        }
+
+        /**
+         * @brief Append the roads of the hierarchy arc from one node to another
+         *
+         * @param from node of the path
+         * @param to next node of the path, linked to from by an arc of the hierarchy
+         * @param path list to which the nodes after from are appended, up to to
+         */
+        void unpack(uint32_t from, uint32_t to, vector<uint32_t> &path) const {
+            uint32_t low = (rank[from] < rank[to]) ? from : to, high = from ^ to ^ low;
+            uint32_t middle = NONE;
+            double best = numeric_limits<double>::infinity();
+            for (uint32_t k = upOffsets[low]; k < upOffsets[low + 1]; k++) {
+                if (up[k].to == high && up[k].weight < best) {
+                    best = up[k].weight;
+                    middle = up[k].middle;
+                }
+            }
+            if (middle == NONE) {
+                path.push_back(to);
+                return;
+            }
+            unpack(from, middle, path);
+            unpack(middle, to, path);
+        }
+
+        /**
+         * @brief Settle the next node of one side of a bidirectional search
+         *
+         * @param side search being grown
+         * @param other search from the other end
+         * @param upward whether only arcs of the hierarchy are followed
+         * @param best length of the best path found, updated
+         * @param meet node where the best path found meets, updated
+         */
+        void step(SearchSpace &side, const SearchSpace &other, bool upward, double &best, uint32_t &meet) const {
+            double d = side.heap.minKey();
+            uint32_t v = side.heap.pop();
+            if (d + other.dist[v] < best) {
+                best = d + other.dist[v];
+                meet = v;
+            }
+            if (upward) {
+                // stall on demand: v is not expanded if a higher node gives it a shorter path
+                for (uint32_t k = upOffsets[v]; k < upOffsets[v + 1]; k++)
+                    if (side.dist[up[k].to] + up[k].weight < d) return;
+                for (uint32_t k = upOffsets[v]; k < upOffsets[v + 1]; k++) side.relax(up[k].to, d + up[k].weight, v);
+                return;
+            }
+            for (uint32_t k = graph.offsets[v]; k < graph.offsets[v + 1]; k++) {
+                uint32_t w = graph.neighbours[k];
+                if (side.relax(w, d + graph.lengths[k], v) && d + graph.lengths[k] + other.dist[w] < best) {
+                    best = d + graph.lengths[k] + other.dist[w];
+                    meet = w;
+                }
+            }
+        }
+
+        /**
+         * @brief Distance from every source to every target with a Dijkstra search per source
+         *
+         * @param sources source nodes
+         * @param targets target nodes
+         * @param threads number of threads to use, at least 1
+         * @return vector<double> distances, row by row
+         */
+        vector<double> tableDijkstra(const vector<uint32_t> &sources, const vector<uint32_t> &targets, unsigned threads) const {
+            vector<double> table(sources.size() * targets.size());
+            parallelChunks(0, sources.size(), threads, [&](unsigned, unsigned long lo, unsigned long hi) {
+                SearchSpace space(numNodes());
+                vector<char> isTarget(numNodes(), 0);
+                unsigned long distinct = 0;
+                for (uint32_t t: targets) if (!isTarget[t]) isTarget[t] = 1, distinct++;
+                for (unsigned long i = lo; i < hi; i++) {
+                    space.reset();
+                    space.relax(sources[i], 0, NONE);
+                    for (unsigned long left = distinct; left > 0 && !space.heap.empty();) {
+                        double d = space.heap.minKey();
+                        uint32_t v = space.heap.pop();
+                        left -= isTarget[v];
+                        for (uint32_t k = graph.offsets[v]; k < graph.offsets[v + 1]; k++)
+                            space.relax(graph.neighbours[k], d + graph.lengths[k], v);
+                    }
+                    for (unsigned long j = 0; j < targets.size(); j++) table[i * targets.size() + j] = space.dist[targets[j]];
+                }
+            });
+            return table;
+        }
+
+        /**
+         * @brief Distance from every source to every target with the hierarchy
+         *
+         * An upward search from every target leaves (target, distance) in a bucket at every
+         * node it settles. An upward search from a source then combines its distance to each
+         * node with the buckets of that node.
+         *
+         * @param sources source nodes
+         * @param targets target nodes
+         * @param threads number of threads to use, at least 1
+         * @return vector<double> distances, row by row
+         */
+        vector<double> tableHierarchy(const vector<uint32_t> &sources, const vector<uint32_t> &targets, unsigned threads) const {
+            // upward search spaces of the targets, in parallel, then grouped by node
+            vector<vector<pair<uint32_t, double>>> settled(targets.size());
+            parallelChunks(0, targets.size(), threads, [&](unsigned, unsigned long lo, unsigned long hi) {
+                SearchSpace space(numNodes());
+                for (unsigned long j = lo; j < hi; j++) {
+                    space.reset();
+                    space.relax(targets[j], 0, NONE);
+                    while (!space.heap.empty()) {
+                        double d = space.heap.minKey();
+                        uint32_t v = space.heap.pop();
+                        settled[j].emplace_back(v, d);
+                        for (uint32_t k = upOffsets[v]; k < upOffsets[v + 1]; k++) space.relax(up[k].to, d + up[k].weight, v);
+                    }
+                }
+            });
+            vector<uint32_t> bucketOffsets(numNodes(), 0);
+            for (const vector<pair<uint32_t, double>> &s: settled) for (const pair<uint32_t, double> &e: s) bucketOffsets[e.first]++;
+            prefixSum(bucketOffsets, threads);
+            vector<pair<uint32_t, double>> buckets(bucketOffsets.back());
+            vector<uint32_t> fill(bucketOffsets.begin(), bucketOffsets.end() - 1);
+            for (unsigned long j = 0; j < targets.size(); j++)
+                for (const pair<uint32_t, double> &e: settled[j]) buckets[fill[e.first]++] = make_pair((uint32_t)j, e.second);
+
+            vector<double> table(sources.size() * targets.size(), numeric_limits<double>::infinity());
+            parallelChunks(0, sources.size(), threads, [&](unsigned, unsigned long lo, unsigned long hi) {
+                SearchSpace space(numNodes());
+                for (unsigned long i = lo; i < hi; i++) {
+                    double *row = &table[i * targets.size()];
+                    space.reset();
+                    space.relax(sources[i], 0, NONE);
+                    while (!space.heap.empty()) {
+                        double d = space.heap.minKey();
+                        uint32_t v = space.heap.pop();
+                        for (uint32_t b = bucketOffsets[v]; b < bucketOffsets[v + 1]; b++)
+                            row[buckets[b].first] = min(row[buckets[b].first], d + buckets[b].second);
+                        for (uint32_t k = upOffsets[v]; k < upOffsets[v + 1]; k++) space.relax(up[k].to, d + up[k].weight, v);
+                    }
+                }
+            });
+            return table;
+        }
+
+    public:
+        /**
+         * @brief Construct a new Router object over the roads of a DCEL
+         *
+         * @param dcel DCEL object, whose vertices are the nodes
+         * @param threads number of threads used to export the graph, at least 1
+         */
+        Router(const DCEL &dcel, unsigned threads = 1): graph(primalGraph(dcel, threads)),
+            vertexOf(dcel.vertices.begin(), dcel.vertices.end()), forward(graph.numNodes()), backward(graph.numNodes()) {
+            PROFILE_SCOPE("router");
+            ids.reserve(vertexOf.size());
+            for (uint32_t i = 0; i < vertexOf.size(); i++) ids[vertexOf[i]] = i;
+        }
+
+        /// Number of nodes, which are the vertices of the DCEL
+        uint32_t numNodes() const { return graph.numNodes(); }
+
+        /// Node of a vertex of the DCEL, NONE if it is not one
+        uint32_t node(const Vertex *v) const {
+            auto i = ids.find(v);
+            return (i == ids.end()) ? NONE : i->second;
+        }
+
+        /// Whether contract() was run
+        bool contracted() const { return !rank.empty(); }
+
+        /// Number of edges and shortcuts of the hierarchy
+        unsigned long hierarchySize() const { return up.size(); }
+
+        /**
+         * @brief Build the contraction hierarchy, used by all later queries
+         *
+         * Initial priorities are computed with several threads, the removals are sequential.
+         *
+         * @param threads number of threads to use, at least 1
+         */
+        void contract(unsigned threads = 1) {
+            PROFILE_SCOPE("contraction");
+            uint32_t n = numNodes();
+            // remaining edges, keeping the shortest of parallel edges
+            vector<vector<Arc>> adj(n);
+            parallelFor(0, n, threads, [&](unsigned long v) {
+                for (uint32_t k = graph.offsets[v]; k < graph.offsets[v + 1]; k++)
+                    if (graph.neighbours[k] != v) addArc(adj[v], Arc{graph.neighbours[k], NONE, graph.lengths[k]});
+            });
+            vector<int> priority(n);
+            parallelChunks(0, n, threads, [&](unsigned, unsigned long lo, unsigned long hi) {
+                SearchSpace space(n);
+                for (unsigned long v = lo; v < hi; v++) priority[v] = 2 * simulate(adj, space, v, nullptr);
+            });
+
+            // nodes by priority, with lazy updates: a popped node whose priority grew goes back
+            typedef pair<int, uint32_t> Entry;
+            vector<Entry> queue;
+            for (uint32_t v = 0; v < n; v++) queue.emplace_back(priority[v], v);
+            make_heap(queue.begin(), queue.end(), greater<Entry>());
+            SearchSpace space(n);
+            vector<int> removedNeighbours(n, 0), level(n, 0);
+            vector<pair<uint32_t, Arc>> shortcuts;
+            rank.assign(n, 0);
+            upOffsets.assign(n + 1, 0);
+            vector<vector<Arc>> upward(n);
+            for (uint32_t next = 0; !queue.empty();) {
+                pop_heap(queue.begin(), queue.end(), greater<Entry>());
+                uint32_t v = queue.back().second;
+                queue.pop_back();
+                shortcuts.clear();
+                int p = 2 * simulate(adj, space, v, &shortcuts) + removedNeighbours[v] + level[v];
+                if (!queue.empty() && p > queue.front().first) {
+                    queue.emplace_back(p, v);
+                    push_heap(queue.begin(), queue.end(), greater<Entry>());
+                    continue;
+                }
+                rank[v] = next++;
+                for (const Arc &a: adj[v]) {
+                    vector<Arc> &arcs = adj[a.to];
+                    for (unsigned long k = 0; k < arcs.size(); k++) {
+                        if (arcs[k].to != v) continue;
+                        arcs[k] = arcs.back();
+                        arcs.pop_back();
+                        break;
+                    }
+                    removedNeighbours[a.to]++;
+                    level[a.to] = max(level[a.to], level[v] + 1);
+                }
+                for (const pair<uint32_t, Arc> &s: shortcuts) {
+                    addArc(adj[s.first], s.second);
+                    addArc(adj[s.second.to], Arc{s.first, v, s.second.weight});
+                }
+                upward[v].swap(adj[v]);
+            }
+            up.clear();
+            for (uint32_t v = 0; v < n; v++) {
+                upOffsets[v] = up.size();
+                up.insert(up.end(), upward[v].begin(), upward[v].end());
+            }
+            upOffsets[n] = up.size();
+        }
+
+        /**
+         * @brief Length of the shortest path between two nodes
+         *
+         * @param s source node
+         * @param t target node
+         * @param path if not nullptr, receives the nodes of the path from s to t, empty if there is none
+         * @return double length of the path, infinity if t cannot be reached from s
+         */
+        double route(uint32_t s, uint32_t t, vector<uint32_t> *path = nullptr) {
+            forward.reset();
+            backward.reset();
+            forward.relax(s, 0, NONE);
+            backward.relax(t, 0, NONE);
+            double best = numeric_limits<double>::infinity();
+            uint32_t meet = NONE;
+            bool upward = contracted();
+            while (true) {
+                double f = forward.heap.minKey(), b = backward.heap.minKey();
+                if (upward) {
+                    // each side stops on its own, since the meeting node is the highest of the path
+                    if (min(f, b) >= best) break;
+                    if (f <= b) step(forward, backward, true, best, meet);
+                    else step(backward, forward, true, best, meet);
+                }
+                else {
+                    if (f + b >= best) break;
+                    if (f <= b) step(forward, backward, false, best, meet);
+                    else step(backward, forward, false, best, meet);
+                }
+            }
+            if (path == nullptr) return best;
+            path->clear();
+            if (meet == NONE) return best;
+            // nodes of the search tree from s to meet, then from meet to t
+            vector<uint32_t> half;
+            for (uint32_t v = meet; v != NONE; v = forward.parent[v]) half.push_back(v);
+            reverse(half.begin(), half.end());
+            for (uint32_t v = backward.parent[meet]; v != NONE; v = backward.parent[v]) half.push_back(v);
+            path->push_back(s);
+            for (unsigned long i = 1; i < half.size(); i++) {
+                if (upward) unpack(half[i - 1], half[i], *path);
+                else path->push_back(half[i]);
+            }
+            return best;
+        }
+
+        /**
+         * @brief Length of the shortest path between two vertices of the DCEL
+         *
+         * @param s source vertex
+         * @param t target vertex
+         * @param path if not nullptr, receives the vertices of the path from s to t
+         * @return double length of the path, infinity if there is none or a vertex is not in the DCEL
+         */
+        double route(const Vertex *s, const Vertex *t, vector<const Vertex *> *path = nullptr) {
+            uint32_t a = node(s), b = node(t);
+            if (path != nullptr) path->clear();
+            if (a == NONE || b == NONE) return numeric_limits<double>::infinity();
+            vector<uint32_t> nodes;
+            double d = route(a, b, path ? &nodes : nullptr);
+            if (path != nullptr) for (uint32_t v: nodes) path->push_back(dcelVertex(v));
+            return d;
+        }
+
+        /**
+         * @brief Distances from every source to every target
+         *
+         * With the hierarchy, runs one upward search per source and per target; without it,
+         * one Dijkstra search per source that stops once every target is settled. Sources
+         * (and targets) are split among the threads.
+         *
+         * @param sources source nodes
+         * @param targets target nodes
+         * @param threads number of threads to use, at least 1
+         * @return vector<double> distance from sources[i] to targets[j] at i * targets.size() + j, infinity if unreachable
+         */
+        vector<double> table(const vector<uint32_t> &sources, const vector<uint32_t> &targets, unsigned threads = 1) const {
+            PROFILE_SCOPE("distance table");
+            if (contracted()) return tableHierarchy(sources, targets, threads);
+            return tableDijkstra(sources, targets, threads);
+        }
+
+        /// Vertex of the DCEL of a node
+        const Vertex* dcelVertex(uint32_t v) const { return vertexOf[v]; }
+};
+
+#endif
@@ -0,0 +1,418 @@
+/**
+ * @file Simplify.h
+ * @brief This file contains a topology preserving simplification of the chains of a road network
+ *
+ * Curved roads are stored as many short, almost collinear edges whose inner vertices have
+ * only two edges. Removing such vertices before building the DCEL saves time and memory
+ * without changing the faces, as long as no removed piece of road swings over another
+ * vertex or edge. ChainSimplifier runs the Douglas-Peucker algorithm on every chain of
+ * degree 2 vertices and only accepts shortcuts which keep the map planar.
+ */
+
+#ifndef __SIMPLIFY_H__
+#define __SIMPLIFY_H__
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+#include "Geometry.h"
+#include "VertexGrid.h"
+#include "Parallel.h"
+#include "Predicates.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @class ChainSimplifier
+ * @brief Douglas-Peucker simplification of the chains of degree 2 vertices of a list of edges
+ *
+ * Endpoints are merged with the same tolerance as DCEL, and the edges are cut into chains:
+ * maximal paths whose inner vertices have exactly two edges, plus closed cycles made of such
+ * vertices only. Each chain is simplified on its own, keeping its two ends. A chain whose
+ * ends are the same vertex, or a cycle, is first cut in three so that it stays a polygon,
+ * and a chain sharing both ends with another chain keeps at least one inner vertex.
+ *
+ * A shortcut replacing the piece of chain from p_i to p_j is only taken if it is within the
+ * tolerance of every removed vertex, no vertex of the input outside the piece lies inside or
+ * on the polygon p_i ... p_j, and the shortcut meets no other input edge except at p_i or
+ * p_j. Since shortcuts are only tested against the input, two accepted shortcuts can not
+ * cross: one would have to leave the polygon of the other through an input edge, which it
+ * may not meet. Chains can therefore be simplified on different threads in any order. The
+ * tests use a uniform grid over the input edges and the exact orientation predicate.
+ *
+ * Edges must not cross each other, see splitIntersections() (Intersections.h).
+ */
+class ChainSimplifier {
+    private:
+        /// Buffers of one thread, marking the vertices and edges a test must skip
+        struct Scratch {
+            vector<uint32_t> pointMark; /**< stamp of the last test which skipped each vertex */
+            vector<uint32_t> edgeMark; /**< stamp of the last test which skipped each edge */
+            uint32_t stamp; /**< number of the current test */
+            vector<pair<unsigned long, unsigned long>> stack; /**< pieces of the chain still to be simplified */
+        };
+
+        vector<Vertex> points; /**< distinct endpoints of the edges */
+        vector<pair<uint32_t, uint32_t>> ends; /**< endpoints of every input edge, as indices into points */
+        vector<unsigned long> chainStart; /**< first entry of every chain in chainPoints, one more entry than chains */
+        vector<uint32_t> chainPoints; /**< vertices of all the chains, chain after chain */
+        vector<uint32_t> chainEdges; /**< input edge from each entry of chainPoints to the next, unused at the end of a chain */
+        vector<char> twin; /**< whether another chain joins the same two ends as each chain */
+        vector<unsigned long> tiny; /**< input edges whose endpoints are equal but both kept by DCEL, kept as they are */
+        vector<unsigned long> loose; /**< input edges whose endpoints were merged, kept as they are */
+
+        double minX, minY, cellSize; /**< origin and side of the grid cells */
+        long long nx, ny; /**< number of columns and rows of the grid */
+        vector<uint32_t> cellEdges, cellPoints; /**< edges overlapping and vertices lying in each cell, cell after cell */
+        vector<unsigned long> edgeStart, pointStart; /**< first entry of every cell in cellEdges and cellPoints */
+
+        /// column of x in the grid
+        long long column(double x) const { return min(nx - 1, max(0LL, (long long)floor((x - minX) / cellSize))); }
+
+        /// row of y in the grid
+        long long row(double y) const { return min(ny - 1, max(0LL, (long long)floor((y - minY) / cellSize))); }
+
+        /// distance from point p to the segment from a to b
+        static double distance(const Vertex &p, const Vertex &a, const Vertex &b) {
+            double dx = b.x - a.x, dy = b.y - a.y, len2 = dx * dx + dy * dy;
+            double t = (len2 > 0) ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / len2 : 0;
+            t = min(1.0, max(0.0, t));
+            return hypot(p.x - (a.x + t * dx), p.y - (a.y + t * dy));
+        }
+
+        /// true if p lies on the closed segment from a to b
+        static bool onSegment(const Vertex &p, const Vertex &a, const Vertex &b) {
+            return orientExact(a.x, a.y, b.x, b.y, p.x, p.y) == 0 && min(a.x, b.x) <= p.x && p.x <= max(a.x, b.x)
+                && min(a.y, b.y) <= p.y && p.y <= max(a.y, b.y);
+        }
+
+        /// true if the closed segments ab and cd have a point in common
+        static bool meet(const Vertex &a, const Vertex &b, const Vertex &c, const Vertex &d) {
+            int o1 = orientExact(a.x, a.y, b.x, b.y, c.x, c.y), o2 = orientExact(a.x, a.y, b.x, b.y, d.x, d.y);
+            int o3 = orientExact(c.x, c.y, d.x, d.y, a.x, a.y), o4 = orientExact(c.x, c.y, d.x, d.y, b.x, b.y);
+            if (o1 * o2 < 0 && o3 * o4 < 0) return true;
+            return onSegment(c, a, b) || onSegment(d, a, b) || onSegment(a, c, d) || onSegment(b, c, d);
+        }
+
+        /**
+         * @brief Check that chain entries i ... j can be replaced by one edge
+         *
+         * @param i entry of the first vertex of the piece in chainPoints
+         * @param j entry of the last vertex of the piece in chainPoints
+         * @param tolerance distance within which all vertices of the piece lie from the shortcut
+         * @param s buffers of the calling thread
+         * @return true if the shortcut keeps the map planar and every vertex on its side
+         */
+        bool shortcutValid(unsigned long i, unsigned long j, double tolerance, Scratch &s) const {
+            s.stamp++;
+            uint32_t pi = chainPoints[i], pj = chainPoints[j];
+            const Vertex &a = points[pi], &b = points[pj];
+            double x0 = a.x, y0 = a.y, x1 = a.x, y1 = a.y;
+            for (unsigned long k = i; k <= j; k++) {
+                const Vertex &p = points[chainPoints[k]];
+                x0 = min(x0, p.x);
+                y0 = min(y0, p.y);
+                x1 = max(x1, p.x);
+                y1 = max(y1, p.y);
+                s.pointMark[chainPoints[k]] = s.stamp;
+                if (k < j) s.edgeMark[chainEdges[k]] = s.stamp;
+            }
+            for (long long cx = column(x0); cx <= column(x1); cx++) {
+                for (long long cy = row(y0); cy <= row(y1); cy++) {
+                    unsigned long cell = cx * ny + cy;
+                    for (unsigned long k = pointStart[cell]; k < pointStart[cell + 1]; k++) {
+                        uint32_t q = cellPoints[k];
+                        if (s.pointMark[q] == s.stamp) continue;
+                        const Vertex &p = points[q];
+                        // the polygon lies within the tolerance of the shortcut, as all its vertices do
+                        if (distance(p, a, b) > tolerance) continue;
+                        if (onSegment(p, a, b)) return false;
+                        bool inside = false;
+                        for (unsigned long e = i; e <= j; e++) {
+                            const Vertex &u = points[chainPoints[e]], &w = points[chainPoints[(e == j) ? i : e + 1]];
+                            if ((u.y > p.y) != (w.y > p.y)) {
+                                int o = orientExact(u.x, u.y, w.x, w.y, p.x, p.y);
+                                if ((w.y > u.y) ? (o > 0) : (o < 0)) inside = !inside;
+                            }
+                        }
+                        if (inside) return false;
+                    }
+                    for (unsigned long k = edgeStart[cell]; k < edgeStart[cell + 1]; k++) {
+                        uint32_t e = cellEdges[k];
+                        if (s.edgeMark[e] == s.stamp) continue;
+                        s.edgeMark[e] = s.stamp; // edges overlap several cells
+                        uint32_t u = ends[e].first, w = ends[e].second;
+                        bool sharesI = (u == pi || w == pi), sharesJ = (u == pj || w == pj);
+                        if (sharesI && sharesJ) return false; // the shortcut would double this edge
+                        if (sharesI || sharesJ) { // may only touch at the shared vertex
+                            uint32_t other = (u == pi || u == pj) ? w : u;
+                            const Vertex &far = sharesI ? b : a;
+                            if (onSegment(points[other], a, b) || onSegment(far, points[u], points[w])) return false;
+                        }
+                        else if (meet(a, b, points[u], points[w])) return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Simplify entries first ... last of a chain, both being kept
+         *
+         * @param first entry of the first vertex of the piece in chainPoints
+         * @param last entry of the last vertex of the piece in chainPoints
+         * @param tolerance largest distance of a removed vertex to the edge replacing it
+         * @param whole whether the piece may be replaced by a single edge
+         * @param keep flag of every entry of chainPoints, cleared for the removed vertices
+         * @param s buffers of the calling thread
+         */
+        void simplifyPiece(unsigned long first, unsigned long last, double tolerance, bool whole, vector<char> &keep, Scratch &s) const {
+            s.stack.assign(1, make_pair(first, last));
+            while (!s.stack.empty()) {
+                unsigned long i = s.stack.back().first, j = s.stack.back().second;
+                s.stack.pop_back();
+                if (j - i < 2) continue;
+                const Vertex &a = points[chainPoints[i]], &b = points[chainPoints[j]];
+                unsigned long far = i + 1;
+                double farthest = -1;
+                for (unsigned long k = i + 1; k < j; k++) {
+                    double d = distance(points[chainPoints[k]], a, b);
+                    if (d > farthest) {
+                        farthest = d;
+                        far = k;
+                    }
+                }
+                if (farthest <= tolerance && (whole || i != first || j != last) && shortcutValid(i, j, tolerance, s)) {
+                    for (unsigned long k = i + 1; k < j; k++) keep[k] = 0;
+                    continue;
+                }
+                s.stack.emplace_back(i, far);
+                s.stack.emplace_back(far, j);
+            }
+        }
+
+    public:
+        /**
+         * @brief Construct a new ChainSimplifier object, finding the chains and indexing the edges
+         *
+         * @param edges list of Edge objects only meeting at common endpoints
+         */
+        ChainSimplifier(const vector<Edge> &edges) {
+            PROFILE_SCOPE("chains");
+            VertexGrid grid;
+            grid.reserve(edges.size());
+            auto find = [&](const Vertex &v) {
+                return grid.search(v, [&](unsigned long i) { return points[i] == v; });
+            };
+            auto add = [&](const Vertex &v) {
+                grid.insert(v, points.size());
+                points.push_back(v);
+                return (uint32_t)(points.size() - 1);
+            };
+            // same merging as the DCEL constructor, which adds both endpoints of an edge when
+            // neither is known, even if they are equal
+            ends.resize(edges.size());
+            vector<char> pinned;
+            for (unsigned long e = 0; e < edges.size(); e++) {
+                long a = find(edges[e].src), b = find(edges[e].dst);
+                bool fresh = (a == -1 && b == -1 && edges[e].src == edges[e].dst);
+                ends[e].first = (a == -1) ? add(edges[e].src) : a;
+                ends[e].second = (b == -1) ? add(edges[e].dst) : b;
+                pinned.resize(points.size(), 0);
+                if (fresh) {
+                    pinned[ends[e].first] = pinned[ends[e].second] = 1;
+                    tiny.push_back(e);
+                }
+            }
+
+            // edges around every vertex, in CSR form
+            unsigned long n = points.size(), m = edges.size();
+            vector<unsigned long> incStart(n + 1, 0);
+            vector<uint32_t> incident;
+            for (unsigned long e = 0; e < m; e++) {
+                if (ends[e].first == ends[e].second) continue;
+                incStart[ends[e].first + 1]++;
+                incStart[ends[e].second + 1]++;
+            }
+            for (unsigned long v = 0; v < n; v++) incStart[v + 1] += incStart[v];
+            incident.resize(incStart[n]);
+            vector<unsigned long> fill(incStart.begin(), incStart.end() - 1);
+            for (unsigned long e = 0; e < m; e++) {
+                if (ends[e].first == ends[e].second) {
+                    loose.push_back(e);
+                    continue;
+                }
+                incident[fill[ends[e].first]++] = e;
+                incident[fill[ends[e].second]++] = e;
+            }
+            auto degree = [&](uint32_t v) { return incStart[v + 1] - incStart[v]; };
+            auto terminal = [&](uint32_t v) { return degree(v) != 2 || pinned[v]; };
+
+            // walk from every end vertex along its degree 2 neighbours, then around the cycles left
+            vector<char> used(m, 0);
+            for (unsigned long e: tiny) used[e] = 1;
+            auto walk = [&](uint32_t v, uint32_t e) {
+                chainStart.push_back(chainPoints.size());
+                while (true) {
+                    used[e] = 1;
+                    chainPoints.push_back(v);
+                    chainEdges.push_back(e);
+                    v = (ends[e].first == v) ? ends[e].second : ends[e].first;
+                    if (terminal(v)) break;
+                    uint32_t next = (incident[incStart[v]] == e) ? incident[incStart[v] + 1] : incident[incStart[v]];
+                    if (used[next]) break; // back to the start of a cycle
+                    e = next;
+                }
+                chainPoints.push_back(v);
+                chainEdges.push_back(e); // unused
+            };
+            for (uint32_t v = 0; v < n; v++) {
+                if (!terminal(v)) continue;
+                for (unsigned long k = incStart[v]; k < incStart[v + 1]; k++)
+                    if (!used[incident[k]]) walk(v, incident[k]);
+            }
+            for (unsigned long e = 0; e < m; e++)
+                if (!used[e] && ends[e].first != ends[e].second) walk(ends[e].first, e);
+            chainStart.push_back(chainPoints.size());
+
+            // chains with the same two ends would become the same edge if both were replaced whole
+            vector<pair<pair<uint32_t, uint32_t>, unsigned long>> byEnds;
+            for (unsigned long c = 0; c < numChains(); c++) {
+                uint32_t a = chainPoints[chainStart[c]], b = chainPoints[chainStart[c + 1] - 1];
+                byEnds.emplace_back(make_pair(min(a, b), max(a, b)), c);
+            }
+            sort(byEnds.begin(), byEnds.end());
+            twin.assign(numChains(), 0);
+            for (unsigned long k = 1; k < byEnds.size(); k++) {
+                if (byEnds[k].first == byEnds[k - 1].first) twin[byEnds[k].second] = twin[byEnds[k - 1].second] = 1;
+            }
+
+            // uniform grid with about one cell per edge
+            minX = minY = 0;
+            double maxX = 0, maxY = 0;
+            if (n > 0) {
+                minX = maxX = points[0].x;
+                minY = maxY = points[0].y;
+            }
+            for (const Vertex &p: points) {
+                minX = min(minX, p.x);
+                maxX = max(maxX, p.x);
+                minY = min(minY, p.y);
+                maxY = max(maxY, p.y);
+            }
+            double w = maxX - minX, h = maxY - minY;
+            cellSize = max(sqrt(w * h / max(1.0, (double)m)), max(w, h) / 4096);
+            if (!(cellSize > 0)) cellSize = 1;
+            nx = (long long)(w / cellSize) + 1;
+            ny = (long long)(h / cellSize) + 1;
+            edgeStart.assign(nx * ny + 1, 0);
+            pointStart.assign(nx * ny + 1, 0);
+            for (int pass = 0; pass < 2; pass++) {
+                vector<unsigned long> edgeFill(edgeStart.begin(), edgeStart.end() - 1);
+                for (unsigned long e = 0; e < m; e++) {
+                    const Vertex &a = points[ends[e].first], &b = points[ends[e].second];
+                    for (long long cx = column(min(a.x, b.x)); cx <= column(max(a.x, b.x)); cx++) {
+                        for (long long cy = row(min(a.y, b.y)); cy <= row(max(a.y, b.y)); cy++) {
+                            if (pass == 0) edgeStart[cx * ny + cy + 1]++;
+                            else cellEdges[edgeFill[cx * ny + cy]++] = e;
+                        }
+                    }
+                }
+                vector<unsigned long> pointFill(pointStart.begin(), pointStart.end() - 1);
+                for (uint32_t v = 0; v < n; v++) {
+                    unsigned long cell = column(points[v].x) * ny + row(points[v].y);
+                    if (pass == 0) pointStart[cell + 1]++;
+                    else cellPoints[pointFill[cell]++] = v;
+                }
+                if (pass == 0) {
+                    for (unsigned long c = 0; c + 1 < edgeStart.size(); c++) {
+                        edgeStart[c + 1] += edgeStart[c];
+                        pointStart[c + 1] += pointStart[c];
+                    }
+                    cellEdges.resize(edgeStart.back());
+                    cellPoints.resize(pointStart.back());
+                }
+            }
+        }
+
+        /// Number of chains
+        unsigned long numChains() const { return chainStart.size() - 1; }
+
+        /// Number of distinct endpoints
+        unsigned long numVertices() const { return points.size(); }
+
+        /**
+         * @brief Simplify every chain using several threads
+         *
+         * Chains are split into one contiguous range per thread. Each chain only depends on
+         * the input, so the result does not depend on the number of threads.
+         *
+         * @param tolerance largest distance, in input units, of a removed vertex to the edge replacing it
+         * @param threads number of threads to use, at least 1
+         * @return vector<Edge> edges shorter than epsillion which DCEL keeps, simplified chains in the order they were found, then the edges of zero length
+         */
+        vector<Edge> simplify(double tolerance, unsigned threads = 1) const {
+            PROFILE_SCOPE("simplify");
+            if (threads < 1) threads = 1;
+            vector<char> keep(chainPoints.size(), 1);
+            parallelChunks(0, numChains(), threads, [&](unsigned, unsigned long lo, unsigned long hi) {
+                Scratch s;
+                s.pointMark.assign(points.size(), 0);
+                s.edgeMark.assign(ends.size(), 0);
+                s.stamp = 0;
+                for (unsigned long c = lo; c < hi; c++) {
+                    unsigned long first = chainStart[c], last = chainStart[c + 1] - 1;
+                    if (chainPoints[first] != chainPoints[last]) {
+                        simplifyPiece(first, last, tolerance, !twin[c], keep, s);
+                    }
+                    else if (last - first >= 3) { // closed: keep a triangle at least
+                        unsigned long third = first + (last - first) / 3, twoThirds = first + 2 * (last - first) / 3;
+                        simplifyPiece(first, third, tolerance, true, keep, s);
+                        simplifyPiece(third, twoThirds, tolerance, true, keep, s);
+                        simplifyPiece(twoThirds, last, tolerance, true, keep, s);
+                    }
+                }
+            });
+            vector<Edge> result;
+            for (unsigned long e: tiny) { // first, so that DCEL sees both endpoints as new again
+                const Vertex &a = points[ends[e].first], &b = points[ends[e].second];
+                result.emplace_back(a.x, a.y, b.x, b.y);
+            }
+            for (unsigned long c = 0; c < numChains(); c++) {
+                unsigned long prev = chainStart[c];
+                for (unsigned long k = chainStart[c] + 1; k < chainStart[c + 1]; k++) {
+                    if (!keep[k]) continue;
+                    const Vertex &a = points[chainPoints[prev]], &b = points[chainPoints[k]];
+                    result.emplace_back(a.x, a.y, b.x, b.y);
+                    prev = k;
+                }
+            }
+            for (unsigned long e: loose) {
+                const Vertex &a = points[ends[e].first], &b = points[ends[e].second];
+                result.emplace_back(a.x, a.y, b.x, b.y);
+            }
+            return result;
+        }
+};
+
+/**
+ * @brief Remove the inner vertices of road chains which lie within a tolerance of the road
+ *
+ * Runs a ChainSimplifier once, see there for the guarantees. Meant to be run between
+ * splitIntersections() and the DCEL constructor.
+ *
+ * @param edges list of Edge objects only meeting at common endpoints
+ * @param tolerance largest distance, in input units, of a removed vertex to the edge replacing it
+ * @param threads number of threads to use, at least 1
+ * @return vector<Edge> simplified list of edges with the same faces
+ */
+vector<Edge> simplifyChains(const vector<Edge> &edges, double tolerance, unsigned threads = 1) {
+    ChainSimplifier simplifier(edges);
+    return simplifier.simplify(tolerance, threads);
+}
+
+#endif
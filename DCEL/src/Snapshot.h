@@ -0,0 +1,318 @@
+/**
+ * @file Snapshot.h
+ * @brief This file contains a binary snapshot format of the DCEL which is loaded with mmap
+ *
+ * Building a DCEL from text takes most of the start up time for large networks. A snapshot
+ * stores the arrays of a CompactDCEL as they are in memory, linked with indices instead of
+ * pointers, so the file can be mapped at any address and traversed right away: loading is
+ * one mmap() and a check of the header, with no parsing and no pointer fixups.
+ */
+
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Geometry.h"
+#include "CompactDCEL.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @brief Header at the start of a snapshot file
+ *
+ * Arrays follow the header, each one starting at a multiple of 64 bytes from the start of
+ * the file, in the order x, y, starOffset, star, origin, nextEdge, face, faceRep.
+ *
+ */
+struct SnapshotHeader {
+    char magic[8]; /**< "DCELSNAP" */
+    uint32_t version; /**< version of the layout, SnapshotHeader::currentVersion */
+    uint32_t byteOrder; /**< 0x01020304 written in the byte order of the machine that saved the file */
+    uint32_t numVertices; /**< number of vertices */
+    uint32_t numHalfEdges; /**< number of half-edges */
+    uint32_t numFaces; /**< number of faces */
+    uint32_t reserved; /**< always 0 */
+    uint64_t offset[8]; /**< position in the file of each array */
+    uint64_t fileSize; /**< total size of the file in bytes */
+
+    static const uint32_t currentVersion = 1;
+    static const uint32_t byteOrderMark = 0x01020304;
+
+    /**
+     * @brief Fill the counts and compute the position of every array
+     *
+     * @param nv number of vertices
+     * @param nh number of half-edges
+     * @param nf number of faces
+     */
+    void layout(uint32_t nv, uint32_t nh, uint32_t nf) {
+        memcpy(magic, "DCELSNAP", 8);
+        version = currentVersion;
+        byteOrder = byteOrderMark;
+        numVertices = nv;
+        numHalfEdges = nh;
+        numFaces = nf;
+        reserved = 0;
+        uint64_t pos = sizeof(SnapshotHeader);
+        for (int i = 0; i < 8; i++) {
+            pos = (pos + 63) & ~(uint64_t)63;
+            offset[i] = pos;
+            pos += arrayBytes(i);
+        }
+        fileSize = pos;
+    }
+
+    /**
+     * @brief Size of one array of the snapshot
+     *
+     * @param i position of the array in the layout
+     * @return uint64_t size of the array in bytes
+     */
+    uint64_t arrayBytes(int i) const {
+        switch (i) {
+            case 0: case 1: return (uint64_t)numVertices * sizeof(double);
+            case 2: return ((uint64_t)numVertices + 1) * sizeof(uint32_t);
+            case 3: case 4: case 5: case 6: return (uint64_t)numHalfEdges * sizeof(uint32_t);
+            default: return (uint64_t)numFaces * sizeof(uint32_t);
+        }
+    }
+};
+
+const uint32_t SnapshotHeader::currentVersion;
+const uint32_t SnapshotHeader::byteOrderMark;
+
+/**
+ * @brief Write a compact DCEL to a snapshot file
+ *
+ * @param dcel CompactDCEL object to be saved
+ * @param path path of the file to be written
+ * @return true if the whole file was written
+ */
+bool saveSnapshot(const CompactDCEL &dcel, const string &path) {
+    PROFILE_SCOPE("snapshot save");
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.layout(dcel.numVertices(), dcel.numHalfEdges(), dcel.numFaces());
+    const void *data[8] = {dcel.x.data(), dcel.y.data(), dcel.starOffset.data(), dcel.star.data(),
+        dcel.origin.data(), dcel.nextEdge.data(), dcel.face.data(), dcel.faceRep.data()};
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out.is_open()) return false;
+    out.write((const char *)&header, sizeof(header));
+    static const char zeros[64] = {0};
+    uint64_t pos = sizeof(header);
+    for (int i = 0; i < 8; i++) {
+        out.write(zeros, header.offset[i] - pos);
+        out.write((const char *)data[i], header.arrayBytes(i));
+        pos = header.offset[i] + header.arrayBytes(i);
+    }
+    return out.good();
+}
+
+/**
+ * @brief Write a DCEL to a snapshot file
+ *
+ * The DCEL is first converted to a CompactDCEL, so vertex i of the snapshot is
+ * dcel.vertices[i] and face i is the face with id i.
+ *
+ * @param dcel DCEL object to be saved
+ * @param path path of the file to be written
+ * @return true if the whole file was written
+ */
+bool saveSnapshot(DCEL &dcel, const string &path) {
+    return saveSnapshot(CompactDCEL(dcel), path);
+}
+
+/**
+ * @class DCELSnapshot
+ * @brief Read only view of a DCEL mapped from a snapshot file
+ *
+ * The accessors are the same as the ones of CompactDCEL, they read the arrays straight
+ * from the mapped file. Pages are brought in by the kernel on first access and shared
+ * between all the processes mapping the same file. The view is only valid while the
+ * object lives, and it cannot be copied.
+ */
+class DCELSnapshot {
+    public:
+        static const uint32_t none = CompactDCEL::none; /**< index used to denote a missing element */
+
+        const double *x; /**< x coordinate of each vertex */
+        const double *y; /**< y coordinate of each vertex */
+        const uint32_t *starOffset; /**< CSR offsets into star, one more entry than vertices */
+        const uint32_t *star; /**< half-edges leaving each vertex in clockwise order */
+        const uint32_t *origin; /**< tail vertex of each half-edge */
+        const uint32_t *nextEdge; /**< next half-edge around the face of each half-edge */
+        const uint32_t *face; /**< face to the left of each half-edge */
+        const uint32_t *faceRep; /**< representative half-edge of each face */
+
+        /**
+         * @brief Construct a new empty DCELSnapshot object
+         *
+         */
+        DCELSnapshot(): base(nullptr), length(0), header(nullptr) { clear(); }
+
+        /**
+         * @brief Map a snapshot file, see open()
+         *
+         * @param path path of the snapshot file
+         */
+        DCELSnapshot(const string &path): base(nullptr), length(0), header(nullptr) { open(path); }
+
+        DCELSnapshot(const DCELSnapshot &) = delete;
+        DCELSnapshot& operator=(const DCELSnapshot &) = delete;
+
+        /**
+         * @brief Destroy the DCELSnapshot object and unmap its file
+         *
+         */
+        ~DCELSnapshot() { close(); }
+
+        /**
+         * @brief Map a snapshot file and check its header
+         *
+         * The header must have the right magic, version and byte order, and the file must
+         * be large enough to hold every array at an aligned position. The arrays themselves
+         * are not read, so this takes the same time for any size of file.
+         *
+         * @param path path of the snapshot file
+         * @return true if the file was mapped, false if it could not be read or is not a valid snapshot
+         */
+        bool open(const string &path) {
+            PROFILE_SCOPE("snapshot load");
+            close();
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd == -1) return false;
+            struct stat st;
+            if (fstat(fd, &st) == -1 || (uint64_t)st.st_size < sizeof(SnapshotHeader)) {
+                ::close(fd);
+                return false;
+            }
+            void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd); // the mapping stays valid after closing the file
+            if (p == MAP_FAILED) return false;
+            base = (const char *)p;
+            length = st.st_size;
+            header = (const SnapshotHeader *)base;
+            if (!valid()) {
+                close();
+                return false;
+            }
+            const void **arrays[8] = {(const void **)&x, (const void **)&y, (const void **)&starOffset,
+                (const void **)&star, (const void **)&origin, (const void **)&nextEdge, (const void **)&face,
+                (const void **)&faceRep};
+            for (int i = 0; i < 8; i++) *arrays[i] = base + header->offset[i];
+            return true;
+        }
+
+        /**
+         * @brief Unmap the file, leaving an empty view
+         *
+         */
+        void close() {
+            if (base != nullptr) munmap((void *)base, length);
+            base = nullptr;
+            length = 0;
+            header = nullptr;
+            clear();
+        }
+
+        /// true if a snapshot is mapped
+        bool isOpen() const { return base != nullptr; }
+
+        /// Number of vertices in the structure
+        uint32_t numVertices() const { return header ? header->numVertices : 0; }
+
+        /// Number of half-edges in the structure (twice the number of edges)
+        uint32_t numHalfEdges() const { return header ? header->numHalfEdges : 0; }
+
+        /// Number of faces in the structure
+        uint32_t numFaces() const { return header ? header->numFaces : 0; }
+
+        /// Twin of the given half-edge
+        static uint32_t twin(uint32_t h) { return h ^ 1; }
+
+        /// Tail vertex of the given half-edge
+        uint32_t tail(uint32_t h) const { return origin[h]; }
+
+        /// Head vertex of the given half-edge
+        uint32_t head(uint32_t h) const { return origin[h ^ 1]; }
+
+        /// Next half-edge around the face of the given half-edge
+        uint32_t next(uint32_t h) const { return nextEdge[h]; }
+
+        /**
+         * @brief Previous half-edge around the face of the given half-edge, see CompactDCEL::prev()
+         *
+         * @param h half-edge whose previous half-edge is required
+         * @return uint32_t half-edge p such that next(p) == h
+         */
+        uint32_t prev(uint32_t h) const {
+            uint32_t v = origin[h], s = starOffset[v], e = starOffset[v + 1];
+            for (uint32_t i = s; i < e; i++)
+                if (star[i] == h) return twin(star[(i == s) ? e - 1 : i - 1]);
+            return none;
+        }
+
+        /**
+         * @brief Print the directional halfedges which surround the face
+         *
+         * Output format is the same as DCEL::printBoundaryEdges()
+         *
+         * @param f index of the face
+         */
+        void printBoundaryEdges(uint32_t f) const {
+            uint32_t h = faceRep[f];
+            do {
+                cout << "HEdge: " << Vertex(x[tail(h)], y[tail(h)]) << " -> " << Vertex(x[head(h)], y[head(h)]) << "\n";
+                h = nextEdge[h];
+            } while (h != faceRep[f]);
+            cout << "\n";
+        }
+
+    private:
+        const char *base; /**< start of the mapping, nullptr if nothing is mapped */
+        uint64_t length; /**< size of the mapping in bytes */
+        const SnapshotHeader *header; /**< header at the start of the mapping */
+
+        /**
+         * @brief Check the header of the mapped file
+         *
+         * @return true if the header describes arrays which fit in the file
+         */
+        bool valid() const {
+            if (memcmp(header->magic, "DCELSNAP", 8) != 0) return false;
+            if (header->version != SnapshotHeader::currentVersion) return false;
+            if (header->byteOrder != SnapshotHeader::byteOrderMark) return false;
+            if (header->numHalfEdges % 2 != 0 || header->fileSize != length) return false;
+            for (int i = 0; i < 8; i++) {
+                if (header->offset[i] % 64 != 0 || header->offset[i] < sizeof(SnapshotHeader)) return false;
+                if (header->offset[i] > length || header->arrayBytes(i) > length - header->offset[i]) return false;
+            }
+            // the star of the last vertex must end with the last half-edge
+            const uint32_t *offsets = (const uint32_t *)(base + header->offset[2]);
+            return offsets[0] == 0 && offsets[header->numVertices] == header->numHalfEdges;
+        }
+
+        /**
+         * @brief Point all the arrays to nothing
+         *
+         */
+        void clear() {
+            x = y = nullptr;
+            starOffset = star = origin = nextEdge = face = faceRep = nullptr;
+        }
+};
+
+const uint32_t DCELSnapshot::none;
+
+#endif
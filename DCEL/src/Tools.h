@@ -17,6 +17,7 @@
 #include <sstream>
 #include <iostream>
 #include "DCEL.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -29,6 +30,7 @@ using namespace std;
  * @return int -1 if clockwise, +1 if anti-clockwise and 0 if colinear points
  */
 int orient(const Vertex &p, const Vertex &q, const Vertex &r) {
+    PROFILE_COUNT(ORIENT_CALLS);
     // counter clock wise: +ve: upward direction: +ve orient
     double x = ((q.x*r.y-r.x*q.y) - p.x*(r.y-q.y) + p.y*(r.x-q.x));
     if (abs(x - 0) < epsillion) return 0;
@@ -51,6 +53,7 @@ void log(string s) {
  * @return vector<Edge> List of edges of present in the planar map, taken from user/file input
  */
 vector<Edge> readEdges(int argc, char *argv[]) {
+    PROFILE_SCOPE("parse");
     string current_exec_name = argv[0]; // Name of the current exec program
     vector<string> all_args;    // arguments to be stored in string format
     vector<Edge> edges;     // to store input edges and return them to caller
@@ -63,7 +66,7 @@ vector<Edge> readEdges(int argc, char *argv[]) {
     }
 
     if (argc > 1 && all_args[0] == "help") { // asking help
-        cout << "KirkPatrick Planar Point Location Program\n"
+        cout << "DCEL Planar Point Location Program\n"
             << "Input: filename as command line argument.\n"
             << "Output: face number, one incident edge and vertex of the corresponding face\n"
             << "\nFile Format:\n"
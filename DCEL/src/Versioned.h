@@ -0,0 +1,237 @@
+/**
+ * @file Versioned.h
+ * @brief This file contains a DCEL edited by one writer while readers traverse published versions
+ *
+ * A DCEL is edited in place, so a query running during addEdge() may follow half-edges that
+ * are being relinked. VersionedDCEL keeps the DCEL being edited private to the writer, and
+ * readers only see immutable versions of it, published after each batch of edits. Readers
+ * never lock: they announce the oldest version they may hold with one atomic store, and a
+ * version is freed once no reader can hold it.
+ */
+
+#ifndef __VERSIONED_H__
+#define __VERSIONED_H__
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+#include "Geometry.h"
+#include "DCEL.h"
+#include "CompactDCEL.h"
+#include "PointLocation.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/**
+ * @class DCELVersion
+ * @brief Immutable state of a VersionedDCEL, as published by its writer
+ *
+ * The subdivision is stored as a CompactDCEL, whose vertices, half-edges and faces are
+ * numbered from scratch in every version. Its point location index is built by the first
+ * query, so versions which are never queried do not pay for it. Readers racing for the
+ * first query may each build one, and all but the first one stored are dropped, so no
+ * reader waits for another.
+ */
+class DCELVersion {
+    private:
+        friend class VersionedDCEL;
+
+        uint64_t retiredAt; /**< epoch at which a newer version replaced this one */
+        mutable atomic<TrapezoidalMap *> index; /**< point location over dcel, nullptr until the first query */
+
+    public:
+        const unsigned long number; /**< 1 for the first version, increased by every publish */
+        const CompactDCEL dcel; /**< the subdivision */
+
+        /**
+         * @brief Construct a new DCELVersion object
+         *
+         * @param Number number of this version
+         * @param source DCEL copied into this version
+         */
+        DCELVersion(unsigned long Number, DCEL &source): retiredAt(0), index(nullptr), number(Number), dcel(source) {}
+
+        ~DCELVersion() { delete index.load(); }
+
+        DCELVersion(const DCELVersion &) = delete;
+        DCELVersion& operator=(const DCELVersion &) = delete;
+
+        /**
+         * @brief Point location index over the faces of this version
+         *
+         * @return const TrapezoidalMap& index built over dcel, to be queried with locateIndex()
+         */
+        const TrapezoidalMap& locator() const {
+            TrapezoidalMap *built = index.load();
+            if (built != nullptr) return *built;
+            TrapezoidalMap *mine = new TrapezoidalMap(dcel);
+            if (index.compare_exchange_strong(built, mine)) return *mine;
+            delete mine; // another reader stored its index first
+            return *built;
+        }
+
+        /**
+         * @brief Find the face of this version containing a point
+         *
+         * @param v point to be located
+         * @return uint32_t index of the face of dcel containing v, as given by TrapezoidalMap::locateIndex()
+         */
+        uint32_t locate(const Vertex &v) const { return locator().locateIndex(v); }
+};
+
+/**
+ * @class VersionedDCEL
+ * @brief DCEL with one writer and lock free readers pinning immutable versions
+ *
+ * The writer edits the DCEL returned by edit() with the usual functions (addEdge(),
+ * removeEdge(), splitEdge() ...). Readers do not see these edits until publish() converts
+ * the DCEL into a new DCELVersion and makes it current with one atomic exchange, so every
+ * batch of edits becomes visible at once. Publishing costs O(n), since the pointer DCEL
+ * can not share unchanged objects with a copy: every object is linked to its neighbours.
+ *
+ * Versions are reclaimed with epochs. A reader stores the current epoch in a slot of its
+ * own, then loads the current version; a version replaced at epoch r is freed once every
+ * slot is empty or holds an epoch above r. All the atomics are sequentially consistent,
+ * which guarantees that a reader whose epoch was not seen by the writer loads the newer
+ * version. A reader that never unpins only delays the freeing of versions.
+ *
+ * edit(), publish() and reclaim() must be called from one thread at a time. Readers
+ * create a ReadGuard on any thread and traverse view->dcel or call view->locate().
+ */
+class VersionedDCEL {
+    private:
+        /// Epoch pinned by one reader, padded to the size of a cache line
+        struct ReaderSlot {
+            atomic<uint64_t> pinned; /**< epoch at which the reader loaded its version, 0 if none */
+            atomic<bool> claimed; /**< whether a ReadGuard owns this slot */
+            char padding[64 - 2 * sizeof(uint64_t)];
+
+            ReaderSlot(): pinned(0), claimed(false) {}
+        };
+
+        DCEL dcel; /**< DCEL edited by the writer */
+        atomic<DCELVersion *> current; /**< version given to new readers */
+        atomic<uint64_t> epoch; /**< increased every time a version is replaced, starts at 1 */
+        vector<ReaderSlot> slots; /**< one slot per concurrent reader */
+        vector<DCELVersion *> retired; /**< replaced versions not yet freed */
+
+    public:
+        /**
+         * @class ReadGuard
+         * @brief Access to the current version of a VersionedDCEL, kept alive while the guard lives
+         *
+         * The guard claims a free slot of the VersionedDCEL, pins the current epoch in it and
+         * loads the current version, which stays valid until the guard is destroyed or
+         * refresh() is called. If all the slots are taken, it waits for one to be released.
+         */
+        class ReadGuard {
+            private:
+                VersionedDCEL &owner; /**< versioned DCEL being read */
+                ReaderSlot *slot; /**< slot claimed by this guard */
+                const DCELVersion *version; /**< version pinned by this guard */
+
+            public:
+                /**
+                 * @brief Construct a new ReadGuard object pinning the current version
+                 *
+                 * @param Owner versioned DCEL to be read
+                 */
+                ReadGuard(VersionedDCEL &Owner): owner(Owner), slot(nullptr), version(nullptr) {
+                    for (unsigned long i = 0; slot == nullptr; i = (i + 1) % owner.slots.size()) {
+                        bool expected = false;
+                        if (owner.slots[i].claimed.compare_exchange_strong(expected, true)) slot = &owner.slots[i];
+                    }
+                    refresh();
+                }
+
+                ~ReadGuard() {
+                    slot->pinned.store(0);
+                    slot->claimed.store(false);
+                }
+
+                ReadGuard(const ReadGuard &) = delete;
+                ReadGuard& operator=(const ReadGuard &) = delete;
+
+                /// Move to the current version, releasing the one pinned before
+                void refresh() {
+                    slot->pinned.store(owner.epoch.load());
+                    version = owner.current.load();
+                }
+
+                /// Pinned version
+                const DCELVersion& operator*() const { return *version; }
+                const DCELVersion* operator->() const { return version; }
+        };
+
+        /**
+         * @brief Construct a new VersionedDCEL object and publish its first version
+         *
+         * @param edgelist a List of Edge objects which are used to build the DCEL
+         * @param threads number of threads used to build the DCEL, at least 1
+         * @param maxReaders number of ReadGuard objects that can exist at the same time without waiting
+         */
+        VersionedDCEL(vector<Edge> &edgelist, unsigned threads = 1, unsigned maxReaders = 64): dcel(edgelist, threads),
+            current(nullptr), epoch(1), slots(maxReaders < 1 ? 1 : maxReaders) {
+            current.store(new DCELVersion(1, dcel));
+        }
+
+        ~VersionedDCEL() { // no reader may be left
+            delete current.load();
+            for (DCELVersion *v: retired) delete v;
+        }
+
+        VersionedDCEL(const VersionedDCEL &) = delete;
+        VersionedDCEL& operator=(const VersionedDCEL &) = delete;
+
+        /**
+         * @brief DCEL to be edited by the writer
+         *
+         * @return DCEL& the DCEL, whose edits are not seen by readers until publish()
+         */
+        DCEL& edit() { return dcel; }
+
+        /**
+         * @brief Make the edits done since the last publish visible to new readers
+         *
+         * Readers holding an older version keep it until they refresh or release it. Versions
+         * no longer held are freed on the way.
+         *
+         * @return unsigned long number of the new version
+         */
+        unsigned long publish() {
+            PROFILE_SCOPE("publish");
+            DCELVersion *next = new DCELVersion(current.load()->number + 1, dcel);
+            DCELVersion *old = current.exchange(next);
+            old->retiredAt = epoch.fetch_add(1);
+            retired.push_back(old);
+            reclaim();
+            return next->number;
+        }
+
+        /**
+         * @brief Free the replaced versions which no reader can hold any more
+         *
+         * @return unsigned long number of replaced versions still kept for readers
+         */
+        unsigned long reclaim() {
+            uint64_t oldest = epoch.load();
+            for (ReaderSlot &s: slots) {
+                uint64_t e = s.pinned.load();
+                if (e != 0 && e < oldest) oldest = e;
+            }
+            unsigned long kept = 0;
+            for (DCELVersion *v: retired) {
+                if (v->retiredAt < oldest) delete v;
+                else retired[kept++] = v;
+            }
+            retired.resize(kept);
+            return kept;
+        }
+
+        /// Number of the current version
+        unsigned long version() const { return current.load()->number; }
+};
+
+#endif
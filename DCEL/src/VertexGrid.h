@@ -0,0 +1,201 @@
+/**
+ * @file VertexGrid.h
+ * @brief This file contains a spatial hash grid used to find duplicate vertices in expected O(1) time
+ *
+ */
+
+#ifndef __VERTEXGRID_H__
+#define __VERTEXGRID_H__
+
+#include <cmath>
+#include <vector>
+
+#include "Geometry.h"
+
+using namespace std;
+
+/**
+ * @class VertexGrid
+ * @brief Spatial hash grid over the vertices of a DCEL
+ *
+ * The plane is divided into square cells of side 4 * epsillion and each vertex is stored in
+ * the cell containing it. Two vertices are equal (Vertex::operator==) only if both their
+ * coordinates differ by less than epsillion, hence a vertex equal to a query can only lie
+ * in the cells overlapping the box of side 2 * epsillion around the query, which are 
+ * 2.25 cells on average and never more than 4. Non empty cells are kept in an open addressing
+ * hash table and the vertices of a cell are chained through their indices, so the grid
+ * needs no allocation per vertex.
+ *
+ */
+class VertexGrid {
+    private:
+        /**
+         * @brief An entry of the hash table, holding the first vertex of a non empty cell
+         *
+         */
+        struct Cell {
+            long long cx, cy; /**< integer coordinates of the cell */
+            long head; /**< index of the last vertex inserted in this cell, -1 if the entry is unused, -2 if the cell became empty */
+        };
+
+        vector<Cell> table; /**< open addressing hash table of the non empty cells (size is a power of 2) */
+        vector<long> chain; /**< chain[i] is the index of the vertex inserted before vertex i in the same cell, -1 at the end */
+        unsigned long used; /**< number of entries of the table in use */
+
+        /**
+         * @brief Hash the integer coordinates of a cell into the table
+         *
+         * @param cx x coordinate of the cell
+         * @param cy y coordinate of the cell
+         * @return unsigned long position in the table where probing starts
+         */
+        unsigned long slot(long long cx, long long cy) const {
+            // splitmix64 finalizer over both coordinates
+            unsigned long long h = (unsigned long long)cx * 0x9E3779B97F4A7C15ULL ^ (unsigned long long)cy;
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+            h ^= h >> 31;
+            return h & (table.size() - 1);
+        }
+
+        /**
+         * @brief Find the table entry of a cell
+         *
+         * @param cx x coordinate of the cell
+         * @param cy y coordinate of the cell
+         * @return unsigned long position of the entry of the cell, or of the unused entry where it would be inserted
+         */
+        unsigned long probe(long long cx, long long cy) const {
+            unsigned long i = slot(cx, cy);
+            while (table[i].head != -1 && (table[i].cx != cx || table[i].cy != cy))
+                i = (i + 1) & (table.size() - 1);
+            return i;
+        }
+
+        /**
+         * @brief Double the size of the table and reinsert all the cells
+         *
+         */
+        void grow() {
+            vector<Cell> old;
+            old.swap(table);
+            table.assign(old.size() * 2, Cell{0, 0, -1});
+            used = 0;
+            for (Cell &c: old) {
+                if (c.head < 0) continue; // cells emptied by remove() are dropped
+                table[probe(c.cx, c.cy)] = c;
+                used++;
+            }
+        }
+
+        /**
+         * @brief Integer coordinate of the cell containing the given coordinate
+         *
+         * @param x coordinate along any axis
+         * @return long long cell coordinate along the same axis
+         */
+        static long long cell(double x) {
+            return (long long)floor(x / (4 * epsillion));
+        }
+
+    public:
+        /**
+         * @brief Construct a new empty VertexGrid object
+         *
+         */
+        VertexGrid(): table(16, Cell{0, 0, -1}), used(0) {}
+
+        /**
+         * @brief Find a vertex equal to the given vertex
+         *
+         * Among all the equal vertices, the one with the smallest index is returned. This is
+         * the same vertex a linear scan over the list of vertices would return.
+         *
+         * @param v Vertex object to be searched
+         * @param vertices list of vertices whose indices are stored in the grid
+         * @return Vertex* pointer to the matching vertex, nullptr if there is none
+         */
+        Vertex* find(const Vertex &v, const vector<Vertex *> &vertices) const {
+            long k = search(v, [&](unsigned long i) { return *vertices[i] == v; });
+            return (k == -1) ? nullptr : vertices[k];
+        }
+
+        /**
+         * @brief Find the smallest index near the given vertex which satisfies a predicate
+         * 
+         * All the indices stored in cells which can hold a vertex equal to v are tested with
+         * the predicate. This lets the grid be used over any storage of coordinates.
+         * 
+         * @tparam Match callable taking an index and returning true if that vertex equals v
+         * @param v Vertex object to be searched
+         * @param match predicate deciding equality of the vertex at an index
+         * @return long smallest matching index, -1 if there is none
+         */
+        template <class Match>
+        long search(const Vertex &v, Match match) const {
+            long long xmax = cell(v.x + epsillion), ymax = cell(v.y + epsillion);
+            long best = -1;
+            for (long long i = cell(v.x - epsillion); i <= xmax; i++) {
+                for (long long j = cell(v.y - epsillion); j <= ymax; j++) {
+                    const Cell &c = table[probe(i, j)];
+                    for (long k = c.head; k >= 0; k = chain[k]) {
+                        if ((best == -1 || k < best) && match(k)) best = k;
+                    }
+                }
+            }
+            return best;
+        }
+
+        /**
+         * @brief Insert a vertex into the grid
+         *
+         * @param v Vertex object to be inserted
+         * @param index index of the vertex in the list of vertices passed to find()
+         */
+        void insert(const Vertex &v, unsigned long index) {
+            if (2 * (used + 1) > table.size()) grow();
+            if (chain.size() <= index) chain.resize(index + 1, -1);
+            long long cx = cell(v.x), cy = cell(v.y);
+            Cell &c = table[probe(cx, cy)];
+            if (c.head == -1) {
+                c = Cell{cx, cy, -1};
+                used++;
+            }
+            chain[index] = (c.head < 0) ? -1 : c.head;
+            c.head = index;
+        }
+
+        /**
+         * @brief Remove a vertex from the grid
+         *
+         * An emptied cell keeps its entry in the table (marked -2) so that the probe
+         * sequences going through it stay valid; such entries are dropped when the table grows.
+         *
+         * @param v Vertex object which was inserted with the given index
+         * @param index index of the vertex to be removed
+         */
+        void remove(const Vertex &v, unsigned long index) {
+            Cell &c = table[probe(cell(v.x), cell(v.y))];
+            if (c.head == (long)index) {
+                c.head = (chain[index] == -1) ? -2 : chain[index];
+            }
+            else {
+                long k = c.head;
+                while (chain[k] != (long)index) k = chain[k];
+                chain[k] = chain[index];
+            }
+            chain[index] = -1;
+        }
+
+        /**
+         * @brief Reserve space for the given number of vertices
+         *
+         * @param n expected number of vertices
+         */
+        void reserve(unsigned long n) {
+            chain.reserve(n);
+            while (table.size() < 2 * n) grow();
+        }
+};
+
+#endif
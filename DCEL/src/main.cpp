@@ -8,7 +8,9 @@
 #include <chrono>
 #include <iostream>
 #include "DCEL.h"
+#include "Intersections.h"
 #include "Tools.h"
+#include "Profiler.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -28,17 +30,21 @@ int main(int argc, char *argv[]) {
     vector<Edge> inputEdges = readEdges(argc, argv);
     auto lap1 = high_resolution_clock::now();
 
-    // build dcel structure
-    DCEL dcel = DCEL(inputEdges);
+    // split edges where they cross so that they only meet at endpoints
+    vector<Edge> planarEdges = splitIntersections(inputEdges);
     auto lap2 = high_resolution_clock::now();
 
+    // build dcel structure
+    DCEL dcel(planarEdges);
+    auto lap3 = high_resolution_clock::now();
+
     // Vertex *a = dcel.getVertex(Vertex(0, 0));
     // Vertex *b = dcel.getVertex(Vertex(1, 1));
-    // dcel.addEdge(a, b);
+    // dcel.addEdge(*a, *b);
 
     // print DECL
     // for (Vertex* v: dcel.vertices) {
-    //     vector<HalfEdge*> helist = dcel.heMap[v];
+    //     Star &helist = dcel.heMap[v];
     //     for (HalfEdge* he: helist) {
     //         cout << *he << ", Face: " << he->face->id << "\n";
     //     }
@@ -53,13 +59,17 @@ int main(int argc, char *argv[]) {
     cout << "\n";
     cout << "Number of Vertices: " << dcel.vertices.size() << "\n";
     cout << "Number of Edges: " << inputEdges.size() << "\n";
+    cout << "Number of Edges after splitting intersections: " << planarEdges.size() << "\n";
     cout << "Number of Faces: " << dcel.faces.size() << "\n\n";
 
     // Print time analysis
     auto input_time = duration_cast<microseconds>(lap1 - start);
-    auto run_time = duration_cast<microseconds>(lap2 - lap1);
+    auto split_time = duration_cast<microseconds>(lap2 - lap1);
+    auto run_time = duration_cast<microseconds>(lap3 - lap2);
     cout << "Time taken for input: " << input_time.count() << " microsec\n";
+    cout << "Time taken for splitting intersections: " << split_time.count() << " microsec\n";
     cout << "Time taken for building DCEL: " << run_time.count() << " microsec\n";
+    PROFILE_REPORT();
     return 0;
 }
 
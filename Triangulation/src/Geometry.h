@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <vector>
+#include "Profiler.h"
 //forward declarations
 class Edge;
 class Face;
@@ -122,7 +123,7 @@ class Vertex {
          * @param v Vertex object to be subtracted
          * @return Vertex Vertex with the final values after subtraction
          */
-        Vertex operator-(const Vertex &v) {
+        Vertex operator-(const Vertex &v) const {
             return Vertex(x-v.x, y-v.y);
         }
 };
@@ -252,7 +253,7 @@ ostream& operator<<(ostream &os, const Face &f) {
  */
 class Triangle {
     public:
-        vector<Vertex> v;
+        vector<Vertex, ProfileAllocator<Vertex>> v;
 
         /**
          * @brief Construct a new Triangle object
@@ -272,7 +273,7 @@ class Triangle {
          * @param b Second Vertex
          * @param c Third Vertex
          */
-        Triangle(Vertex &a, Vertex &b, Vertex &c) {
+        Triangle(const Vertex &a, const Vertex &b, const Vertex &c) {
             v.push_back(a);
             v.push_back(b);
             v.push_back(c);
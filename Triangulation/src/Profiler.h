@@ -0,0 +1,271 @@
+/**
+ * @file Profiler.h
+ * @brief Lightweight phase timers and hot-path counters for profiling runs
+ *
+ * Profiling is enabled by compiling with <em>-DPROFILE</em> (for example
+ * <em>g++ -O2 -DPROFILE main.cpp</em>). When enabled, PROFILE_SCOPE() records
+ * a timed phase, PROFILE_COUNT() bumps one of the counters listed in
+ * ProfileCounter and PROFILE_REPORT() writes a Chrome trace-event JSON file
+ * (open it in chrome://tracing or ui.perfetto.dev) and prints a summary table
+ * to stderr. The trace file path is taken from the PROFILE_TRACE environment
+ * variable and defaults to <em>trace.json</em>.
+ *
+ * Without -DPROFILE all the macros expand to nothing and ProfileAllocator is
+ * std::allocator, so the instrumented code compiles exactly as before.
+ */
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <memory>
+
+/**
+ * @brief Counters which can be incremented with PROFILE_COUNT()
+ *
+ */
+enum ProfileCounter {
+    ORIENT_CALLS,       /**< calls made to orient() */
+    TANGENT_STEPS,      /**< steps taken while walking hulls for a tangent */
+    SWEEP_STATUS_OPS,   /**< insert/remove/search operations on a sweep line status */
+    ALLOCATIONS,        /**< storage requested through ProfileAllocator or a pool */
+    NUM_PROFILE_COUNTERS
+};
+
+#ifdef PROFILE
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+/**
+ * @class Profiler
+ * @brief Collects timed phases and counters from all threads
+ *
+ * Every thread records its phases into its own buffer so that timing a scope
+ * never takes a lock. The buffers are owned by the profiler, hence they stay
+ * alive after their threads have exited and can be reported at the end of the run.
+ */
+class Profiler {
+    public:
+        /**
+         * @brief A single completed phase, stored as a Chrome "complete" event
+         *
+         */
+        struct Event {
+            const char *name; /**< name of the phase (must be a string literal) */
+            double start; /**< start time in microseconds since the profiler was created */
+            double duration; /**< duration of the phase in microseconds */
+        };
+
+        /**
+         * @brief Aggregated time of all the phases sharing a name
+         *
+         */
+        struct Total {
+            const char *name;
+            unsigned long long calls;
+            double duration;
+        };
+
+        /**
+         * @brief Per thread buffer of recorded events and totals
+         *
+         */
+        struct ThreadBuffer {
+            unsigned long tid;
+            vector<Event> events;
+            vector<Total> totals;
+        };
+
+        static const unsigned long maxEventsPerThread = 1 << 20; /**< events beyond this are only counted in totals */
+
+        atomic<unsigned long long> counters[NUM_PROFILE_COUNTERS]; /**< current value of every ProfileCounter */
+
+        /**
+         * @brief Get the process wide profiler object
+         *
+         * @return Profiler& the profiler instance
+         */
+        static Profiler& instance() {
+            static Profiler profiler;
+            return profiler;
+        }
+
+        /**
+         * @brief Time elapsed since the profiler was created
+         *
+         * @return double elapsed time in microseconds
+         */
+        double now() const {
+            return chrono::duration<double, micro>(chrono::steady_clock::now() - origin).count();
+        }
+
+        /**
+         * @brief Get the buffer of the calling thread, registering it on first use
+         *
+         * @return ThreadBuffer& buffer owned by the calling thread
+         */
+        ThreadBuffer& buffer() {
+            static thread_local ThreadBuffer *local = nullptr;
+            if (local == nullptr) {
+                lock_guard<mutex> lock(registry);
+                buffers.emplace_back(new ThreadBuffer());
+                local = buffers.back().get();
+                local->tid = buffers.size() - 1;
+            }
+            return *local;
+        }
+
+        /**
+         * @brief Record a completed phase for the calling thread
+         *
+         * @param name name of the phase
+         * @param start start time as returned by now()
+         * @param end end time as returned by now()
+         */
+        void record(const char *name, double start, double end) {
+            ThreadBuffer &b = buffer();
+            if (b.events.size() < maxEventsPerThread)
+                b.events.push_back(Event{name, start, end - start});
+            for (Total &t: b.totals) {
+                if (t.name == name) {
+                    t.calls++;
+                    t.duration += end - start;
+                    return;
+                }
+            }
+            b.totals.push_back(Total{name, 1, end - start});
+        }
+
+        /**
+         * @brief Write the Chrome trace file and print the summary to stderr
+         *
+         */
+        void report() {
+            const char *env = getenv("PROFILE_TRACE");
+            string path = (env != nullptr) ? env : "trace.json";
+            lock_guard<mutex> lock(registry);
+            ofstream trace(path);
+            trace << "{\"traceEvents\":[\n";
+            bool first = true;
+            for (auto &b: buffers) {
+                for (Event &e: b->events) {
+                    trace << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":0"
+                        << ",\"tid\":" << b->tid << ",\"ts\":" << e.start << ",\"dur\":" << e.duration << "}";
+                    first = false;
+                }
+            }
+            double end = now();
+            for (int i = 0; i < NUM_PROFILE_COUNTERS; i++) {
+                trace << (first ? "" : ",\n") << "{\"name\":\"" << counterNames[i] << "\",\"ph\":\"C\",\"pid\":0"
+                    << ",\"tid\":0,\"ts\":" << end << ",\"args\":{\"value\":" << counters[i].load() << "}}";
+                first = false;
+            }
+            trace << "\n]}\n";
+            trace.close();
+
+            // merge the totals of all threads by phase name
+            vector<Total> totals;
+            for (auto &b: buffers) {
+                for (Total &t: b->totals) {
+                    bool found = false;
+                    for (Total &m: totals) {
+                        if (string(m.name) == t.name) {
+                            m.calls += t.calls;
+                            m.duration += t.duration;
+                            found = true;
+                            break;
+                        }
+                    }
+                    if (!found) totals.push_back(t);
+                }
+            }
+            cerr << "\nProfile summary (trace written to " << path << ")\n";
+            for (Total &t: totals)
+                cerr << "  phase " << t.name << ": " << t.calls << " calls, " << (unsigned long long)t.duration << " microsec\n";
+            for (int i = 0; i < NUM_PROFILE_COUNTERS; i++)
+                cerr << "  counter " << counterNames[i] << ": " << counters[i].load() << "\n";
+        }
+
+    private:
+        chrono::steady_clock::time_point origin; /**< time at which the profiler was created */
+        mutex registry; /**< guards the list of thread buffers */
+        vector<unique_ptr<ThreadBuffer>> buffers; /**< buffers of all threads that recorded a phase */
+        const char *counterNames[NUM_PROFILE_COUNTERS] = {"orient", "tangent_steps", "sweep_status_ops", "allocations"};
+
+        Profiler(): origin(chrono::steady_clock::now()) {
+            for (auto &c: counters) c.store(0);
+        }
+};
+
+/**
+ * @class ProfileScope
+ * @brief Times the enclosing scope and records it as a phase when destroyed
+ *
+ */
+class ProfileScope {
+    private:
+        const char *name;
+        double start;
+
+    public:
+        ProfileScope(const char *Name): name(Name), start(Profiler::instance().now()) {}
+        ~ProfileScope() {
+            Profiler &p = Profiler::instance();
+            p.record(name, start, p.now());
+        }
+};
+
+/**
+ * @class ProfileAllocator
+ * @brief std::allocator which counts its allocations in the ALLOCATIONS counter
+ *
+ * Containers on hot paths name it as their allocator, so allocations are counted without
+ * replacing the global operator new.
+ *
+ * @tparam T type of the allocated objects
+ */
+template <class T>
+class ProfileAllocator: public allocator<T> {
+    public:
+        template <class U>
+        struct rebind {
+            typedef ProfileAllocator<U> other;
+        };
+
+        ProfileAllocator() noexcept {}
+
+        template <class U>
+        ProfileAllocator(const ProfileAllocator<U> &) noexcept {}
+
+        T* allocate(size_t n) {
+            Profiler::instance().counters[ALLOCATIONS].fetch_add(1, memory_order_relaxed);
+            return allocator<T>::allocate(n);
+        }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNT(counter) Profiler::instance().counters[counter].fetch_add(1, memory_order_relaxed)
+#define PROFILE_REPORT() Profiler::instance().report()
+
+#else
+
+template <class T>
+using ProfileAllocator = std::allocator<T>;
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(counter)
+#define PROFILE_REPORT()
+
+#endif
+
+#endif
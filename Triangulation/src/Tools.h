@@ -16,6 +16,7 @@
 #include <fstream>
 #include <sstream>
 #include "Geometry.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -49,6 +50,7 @@ double dist(Vertex const &u, Vertex const &v) {
  * \return Orientation: -1 if clockwise, +1 if counter-clockwise and 0 if colinear
  */
 int orient(const Vertex &p, const Vertex &q, const Vertex &r) {
+    PROFILE_COUNT(ORIENT_CALLS);
     // counter clock wise: +ve: upward direction: +ve orient
     double x = ((q.x*(double)r.y-r.x*(double)q.y) - p.x*(double)(r.y-q.y) + p.y*(double)(r.x-q.x));
     // if (x == 0) return 0;
@@ -95,6 +97,7 @@ void log(string s) {
  * \return vector<Vertex> object containing the input points in the given order
  */
 vector<Vertex> readvertices(int argc, char *argv[]) {
+    PROFILE_SCOPE("parse");
     string current_exec_name = argv[0]; // Name of the current exec program
     vector<string> all_args;
     vector<Vertex> vertices;
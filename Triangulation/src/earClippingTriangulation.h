@@ -34,14 +34,14 @@ vector<Triangle> earClippingTriangulate(vector<Vertex> points) { // the ear clip
 
     bool infiniteLoop = false;
 
-    while (!points.empty()) {
+    while (points.size() > 3) {
         if (infiniteLoop) {
             cout << "Unable to completely triangulate, likely to be a 8 shape or self intersecting polygon\n";
             return triangles;
         }
         infiniteLoop = true;
 
-        for (unsigned long i=0; i<points.size(); i++) {
+        for (unsigned long i=0; i<points.size() && points.size() > 3; i++) {
             // if triangle is inside poly and no point in poly, 
             Vertex &prev = (i>0)?points[i-1]:points[points.size()-1];
             Vertex &next = points[(i+1)%points.size()];
@@ -63,6 +63,7 @@ vector<Triangle> earClippingTriangulate(vector<Vertex> points) { // the ear clip
             }
         }
     }
+    triangles.emplace_back(points[0], points[1], points[2]); // the last three points are the last ear
 
     return triangles;
 }
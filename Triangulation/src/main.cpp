@@ -13,6 +13,7 @@
 #include "Tools.h"
 #include "earClippingTriangulation.h"
 #include "planeSweepTriangulation.h"
+#include "Profiler.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -48,6 +49,7 @@ int main(int argc, char *argv[]) {
     auto run_time = duration_cast<microseconds>(lap2 - lap1);
     cout << "\nTime taken for input: " << input_time.count() << "\n";
     cout << "Time taken for Triangulating: " << run_time.count() << "\n";
+    PROFILE_REPORT();
     return 0;
 }
 
@@ -3,20 +3,29 @@
  * @author Rikil Gajarla (f20170202@hyderabad.bits-pilani.ac.in)
  * @brief This file contains the algorithm to subdivide the polygon into monotones.
  * 
+ * Vertices are named by their 32-bit position in the clockwise list of polygon vertices
+ * given by the user, which is the only place where coordinates are stored. Monotones are
+ * returned as lists of such positions.
+ * 
  */
 
 #ifndef __MONOTONESUBDIVISION_H__
 #define __MONOTONESUBDIVISION_H__
 
+#include <set>
 #include <list>
 #include <vector>
-#include <map>
+#include <cstdint>
+#include <utility>
 #include <algorithm>
 #include "Geometry.h"
 #include "Tools.h"
+#include "Profiler.h"
 
 using namespace std;
 
+const uint32_t noVertex = 0xffffffffu; //< position used when no vertex is given
+
 /**
  * @class Graph
  * @brief This class stores the graph representation of the input polygon
@@ -24,122 +33,97 @@ using namespace std;
  */
 class Graph {
     private:
-        map<unsigned long, vector<unsigned long>> adjList; //< adjacency list to store the connections of each vertex
-        unsigned long originalSize; //< number of nodes present in the graph
-        vector<pair<Vertex, Vertex>> additions; //< List of diagonals which are added to triangulate
+        uint32_t originalSize; //< number of nodes present in the graph
+        vector<pair<uint32_t, uint32_t>> additions; //< List of diagonals which are added to triangulate
 
     public:
-        vector<Vertex> original; //< The original list of untouched polygon vertices as given in clockwise order
+        const vector<Vertex> &original; //< The original list of untouched polygon vertices as given in clockwise order
 
         /**
          * @brief Construct a new Graph object from the clockwise ordering of vertices
          * 
-         * @param input input vertices of polygon as given in clockwise order
+         * Vertex i has an edge with vertex i+1, and the last vertex with the first one.
+         * 
+         * @param input input vertices of polygon as given in clockwise order, kept by reference
          */
-        Graph(vector<Vertex> &input) { // clockwise ordering of vertices
-            originalSize = input.size();
-            original = input;
-            for (unsigned long i=0;i<original.size();i++) { // i has edge with j(i+1)
-                unsigned long j = (i+1)%originalSize;
-                adjList[i].push_back(j);
-                adjList[j].push_back(i);
-                original[i].tag = i; // save vertex index to its tag.
-            }
-        }
+        Graph(const vector<Vertex> &input): originalSize(input.size()), original(input) {}
 
         /**
-         * @brief connect or draw diagonal to the given Vertices 
+         * @brief connect or draw diagonal to the given Vertices
          * 
-         * @param u First Vertex
-         * @param v Second Vertex
+         * @param u position of the first Vertex
+         * @param v position of the second Vertex
          */
-        void connect(const Vertex &u, const Vertex &v) {
-            // TODO: think about perf analysis by using a set for finding
-            unsigned long a = u.tag, b = v.tag;
-            if (find(adjList[a].begin(), adjList[a].end(), b) == adjList[a].end())
-                adjList[a].push_back(b);
-            if (find(adjList[b].begin(), adjList[b].end(), a) == adjList[b].end())
-                adjList[b].push_back(a);
-            if (u.tag - v.tag < 1 || u.tag - v.tag > 1) { // vertices not next to each other
-                additions.push_back(make_pair(u, v));
-            }
+        void connect(uint32_t u, uint32_t v) {
+            if (u == v || prev(u) == v || next(u) == v) return; // vertices next to each other
+            additions.push_back(make_pair(min(u, v), max(u, v)));
         }
 
         /**
          * @brief The previous vertex to the given vertex in the clockwise ordering
          * 
-         * @param v Vertex to which we need previous vertex
-         * @return Vertex The previous Vertex to the given vertex
+         * @param v position of the Vertex to which we need previous vertex
+         * @return uint32_t position of the previous Vertex to the given vertex
          */
-        Vertex prev(Vertex &v) {
-            for (unsigned long i = 0; i<original.size(); i++) {
-                if (original[i] == v) {
-                    if (i > 0) return original[i-1];
-                    else return original[originalSize-1];
-                }
-            }
-            return Vertex(0, 0);
+        uint32_t prev(uint32_t v) const {
+            return (v > 0) ? v - 1 : originalSize - 1;
         }
 
         /**
          * @brief The next vertex to the given vertex in the clockwise ordering
          * 
-         * @param v Vertex to which we need next vertex
-         * @return Vertex The next Vertex to the given vertex
+         * @param v position of the Vertex to which we need next vertex
+         * @return uint32_t position of the next Vertex to the given vertex
          */
-        Vertex next(Vertex &v) {
-            for (unsigned long i = 0; i<original.size(); i++) {
-                if (original[i] == v) {
-                    if (i < originalSize - 1) return original[i + 1];
-                    else return original[0];
-                }
-            }
-            return Vertex(0, 0);
+        uint32_t next(uint32_t v) const {
+            return (v + 1 < originalSize) ? v + 1 : 0;
         }
 
         /**
          * @brief Get the Sub Polygons of the Graph object
          * 
-         * This function returns all the sub polygons which resulted after drawing 
-         * diagonals excluding the original polygon itself. In case no diagonals 
-         * have been drawn, it returns an empty list.
+         * This function returns all the sub polygons which resulted after drawing
+         * diagonals. In case no diagonals have been drawn, it returns the original
+         * polygon only.
+         * 
+         * A diagonal (a, b) with a < b cuts off the vertices a ... b of the boundary.
+         * Diagonals do not cross, so these ranges nest like parentheses. Every sub polygon
+         * is the range of one diagonal (or the whole boundary) where the ranges of the
+         * diagonals directly nested in it are jumped over, from their first to their last
+         * vertex. Sorting the diagonals gives all of them in O(n + d log d).
          * 
-         * @return list<vector<Vertex>> List of sub polygons (cloclwise ordering of points in each polygon)
+         * @return list<vector<uint32_t>> List of sub polygons (cloclwise ordering of vertex positions in each polygon)
          */
-        list<vector<Vertex>> getSubPolygons() {
-            // cycle detection algo to find monotones/polygons and return
-            // them except the full polygon itself (use originalSize to compare)
-            list<vector<Vertex>> monotones;
-            monotones.push_back(original);
-            for (auto &p: additions) {
-                Vertex &u = p.first;
-                Vertex &v = p.second;
-                for (auto itr = monotones.begin(); itr != monotones.end(); itr++) {
-                    auto m = *itr;
-                    auto start = find(m.begin(), m.end(), u);
-                    auto end = find(m.begin(), m.end(), v);
-                    if (start != m.end() && end != m.end()) { // if both vertices exist in one chain
-                        vector<Vertex> left;
-                        vector<Vertex> right;
-                        auto i=start;
-                        for (;i!=end;i++) {
-                            if (i == m.end()) i = m.begin();
-                            if (i == end) break;
-                            left.push_back(*i);
-                        }
-                        left.push_back(*end);
-                        for (;i!=start;i++) {
-                            if (i == m.end()) i = m.begin();
-                            if (i == start) break;
-                            right.push_back(*i);
-                        }
-                        right.push_back(*start);
-                        monotones.erase(itr);
-                        monotones.push_back(left);
-                        monotones.push_back(right);
-                        break;
+        list<vector<uint32_t>> getSubPolygons() {
+            // range of every diagonal, outer ranges before the ones nested in them
+            sort(additions.begin(), additions.end(), [](const pair<uint32_t, uint32_t> &p, const pair<uint32_t, uint32_t> &q) {
+                return p.first < q.first || (p.first == q.first && p.second > q.second);
+            });
+            additions.erase(unique(additions.begin(), additions.end()), additions.end());
+            uint32_t d = additions.size(); // range d is the whole boundary
+            vector<uint32_t> parent(d), stk;
+            vector<uint32_t> childStart(d + 3, 0), children(d);
+            for (uint32_t k = 0; k < d; k++) {
+                while (!stk.empty() && additions[stk.back()].second <= additions[k].first) stk.pop_back();
+                parent[k] = stk.empty() ? d : stk.back();
+                childStart[parent[k] + 2]++;
+                stk.push_back(k);
+            }
+            for (uint32_t k = 2; k < d + 3; k++) childStart[k] += childStart[k - 1];
+            for (uint32_t k = 0; k < d; k++) children[childStart[parent[k] + 1]++] = k; // by increasing first vertex
+            list<vector<uint32_t>> monotones;
+            for (uint32_t k = 0; k <= d; k++) {
+                uint32_t i = (k < d) ? additions[k].first : 0;
+                uint32_t last = (k < d) ? additions[k].second : originalSize - 1;
+                vector<uint32_t> polygon(1, i);
+                for (uint32_t c = childStart[k]; i < last; polygon.push_back(i)) {
+                    while (c < childStart[k + 1] && additions[children[c]].first < i) c++; // jumped over
+                    if (c < childStart[k + 1] && additions[children[c]].first == i && additions[children[c]].second <= last) {
+                        i = additions[children[c++]].second;
                     }
+                    else i++;
                 }
+                monotones.push_back(polygon);
             }
             return monotones;
         }
@@ -149,237 +133,262 @@ class Graph {
  * @class SweepStatus
  * @brief This class represents the sweep line status for the plane sweep algorithm
  * 
- * This class stores the edges which are intersecting with the plane at the current 
+ * This class stores the edges which are intersecting with the plane at the current
  * position. the Edges are ordered based on increasing y coordinate. Provides methods
  * to insert, delete and fetch the intersecting edges
  * 
+ * Edges are named by their position in the polygon: edge i joins vertex i to vertex i+1.
+ * They are kept in a balanced search tree, and the position of each edge in the tree and
+ * its helper are stored by edge, so that finding the edge above a vertex, inserting and
+ * removing take O(log n) and helpers are reached in O(1).
+ * 
  */
 class SweepStatus {
     private:
-        list<pair<Edge, Vertex>> edges; //< The list of Edges which are currently intersecting with the sweep line/plane
+        /**
+         * @brief Order of the edges in the status, from the lowest to the highest
+         * 
+         * Edges of a simple polygon do not cross, so the order of their y coordinates
+         * is the same at every x where the sweep line meets both of them, and the keys
+         * never need to be updated as the line moves. The edge whose left endpoint comes
+         * later is compared with the other one: it is higher if that endpoint (or its right
+         * endpoint when collinear) lies above the other edge. A Vertex compares as a point
+         * that is below an edge only if it lies strictly below its line.
+         */
+        struct Below {
+            using is_transparent = void;
+            const vector<Vertex> *polygon; //< vertices of the polygon in clockwise order
+
+            const Vertex &left(uint32_t e) const {
+                const Vertex &p = (*polygon)[e], &q = (*polygon)[(e + 1) % polygon->size()];
+                return (q < p) ? q : p;
+            }
+
+            const Vertex &right(uint32_t e) const {
+                const Vertex &p = (*polygon)[e], &q = (*polygon)[(e + 1) % polygon->size()];
+                return (q < p) ? p : q;
+            }
+
+            bool operator()(uint32_t a, uint32_t b) const {
+                if (a == b) return false;
+                const Vertex &al = left(a), &ar = right(a), &bl = left(b), &br = right(b);
+                if (!(bl < al)) {
+                    int o = orient(al, ar, bl);
+                    if (o == 0) o = orient(al, ar, br);
+                    return (o == 0) ? a < b : o > 0;
+                }
+                int o = orient(bl, br, al);
+                if (o == 0) o = orient(bl, br, ar);
+                return (o == 0) ? a < b : o < 0;
+            }
+
+            bool operator()(uint32_t e, const Vertex &v) const {
+                return orient(left(e), right(e), v) >= 0;
+            }
+
+            bool operator()(const Vertex &v, uint32_t e) const {
+                return orient(left(e), right(e), v) < 0;
+            }
+        };
+
+        typedef set<uint32_t, Below, ProfileAllocator<uint32_t>> Tree;
+
+        const vector<Vertex> &polygon; //< vertices of the polygon in clockwise order
+        Tree edges; //< The Edges which are currently intersecting with the sweep line/plane, lowest first
+        vector<Tree::iterator> handle; //< Position of each polygon edge in edges, edges.end() if absent
+        vector<uint32_t> helpers; //< position of the helper Vertex of each polygon edge present in edges
+
+        /**
+         * @brief Whether the given edge is in the status
+         * 
+         * @param e position of the edge
+         * @return true if it is present
+         * @return false otherwise, or if e is not an edge of the polygon
+         */
+        bool contains(uint32_t e) {
+            return e < handle.size() && handle[e] != edges.end();
+        }
 
     public:
 
         /**
          * @brief Construct a new Sweep Line Status object
          * 
+         * @param input vertices of the polygon in clockwise order, kept by reference
          */
-        SweepStatus() {}
+        SweepStatus(const vector<Vertex> &input): polygon(input), edges(Below{&input}) {
+            handle.assign(input.size(), edges.end());
+            helpers.assign(input.size(), noVertex);
+        }
 
         /**
          * @brief get the helper Vertex of the given Edge
          * 
-         * @param e Edge to which we need the helper for
-         * @return Vertex The helper vertex of the given edge: helper(e)
+         * @param e position of the Edge to which we need the helper for
+         * @return uint32_t position of the helper vertex of the given edge: helper(e), noVertex if e is not in the status
          */
-        Vertex helper(Edge &e) {
-            // get the helper vertex of this edge
-            for (auto itr = edges.begin(); itr != edges.end(); itr++) {
-                auto p = *itr;
-                if (p.first == e) return p.second;
-            }
-            return Vertex(0, 0);
+        uint32_t helper(uint32_t e) {
+            PROFILE_COUNT(SWEEP_STATUS_OPS);
+            if (!contains(e)) return noVertex;
+            return helpers[e];
         }
 
         /**
          * @brief Set the helper Vertex for given Edge
          * 
-         * setHelper sets helper(e) = v.
+         * setHelper sets helper(e) = v, if e is in the status.
          * 
-         * @param e Edge for which helper must be assigned
-         * @param v Vertex to be assigned as helper
+         * @param e position of the Edge for which helper must be assigned
+         * @param v position of the Vertex to be assigned as helper
          */
-        void setHelper(Edge e, Vertex v) {
-            for (auto &p: edges) {
-                if (p.first == e) {
-                    p.second = v;
-                    break;
-                }
-            }
+        void setHelper(uint32_t e, uint32_t v) {
+            PROFILE_COUNT(SWEEP_STATUS_OPS);
+            if (contains(e)) helpers[e] = v;
         }
 
         /**
          * @brief Insert a new Edge and its helper into the Sweep Line Status
          * 
-         * @param e Edge to insert into status
-         * @param helper helper Vertex of given Edge.
+         * @param e position of the Edge to insert into status
+         * @param helper position of the helper Vertex of given Edge.
          */
-        void insert(const Edge &e, const Vertex &helper) {
-            for (auto itr = edges.begin(); itr != edges.end(); itr++) {
-                auto p = *itr;
-                Edge &test = p.first;
-                Vertex t = (test.src.y>test.dst.y)?test.src:test.dst;
-                Vertex u = (e.src.y>e.dst.y)?e.dst:e.src;
-                if (u.y < t.y) { // insert in this pos
-                    edges.insert(itr, make_pair(e, helper));
-                    return;
-                }
-            }
-            edges.push_back(make_pair(e, helper));
+        void insert(uint32_t e, uint32_t helper) {
+            PROFILE_COUNT(SWEEP_STATUS_OPS);
+            if (!contains(e)) handle[e] = edges.insert(e).first;
+            helpers[e] = helper;
         }
 
         /**
          * @brief Get the Edge which is immediately above the given Vertex in the polygon
          * 
-         * @param v Vertex whose upper Edge is required
-         * @return Edge The edge immediately above Vertex v
+         * An edge of the status ending at v is returned first. If no edge lies above v,
+         * the highest edge is returned.
+         * 
+         * @param v position of the Vertex whose upper Edge is required
+         * @return uint32_t position of the edge immediately above Vertex v, noVertex if the status is empty
          */
-        Edge getUpper(const Vertex &v) {
-            for (auto itr = edges.rbegin(); itr != edges.rend(); itr++) {
-                Edge e = (*itr).first;
-                if (e.src == v || e.dst == v) {
-                    return (*itr).first;
-                }
-                if (orient(e.src, e.dst, v) >= 0) {
-                    return (*(--itr)).first;
-                }
-            }
-            return (*edges.begin()).first;
+        uint32_t getUpper(uint32_t v) {
+            PROFILE_COUNT(SWEEP_STATUS_OPS);
+            uint32_t n = handle.size();
+            if (edges.empty()) return noVertex;
+            if (contains((v + n - 1) % n)) return (v + n - 1) % n;
+            if (contains(v)) return v;
+            auto itr = edges.lower_bound(polygon[v]); // lowest edge with v strictly below it
+            if (itr == edges.end()) return *edges.rbegin(); // no edge above v
+            return *itr;
         }
 
         /**
          * @brief Remove the given Edge from the Sweep Line Status
          * 
-         * This operation can be done preferably when the sweep line/plane is no 
+         * This operation can be done preferably when the sweep line/plane is no
          * longer intersecting with the Edge.
          * 
-         * @param e Edge to be removed from the status
+         * @param e position of the Edge to be removed from the status
          */
-        void remove(const Edge &e) {
-            for (auto itr = edges.begin(); itr != edges.end(); itr++) {
-                if ((*itr).first == e) {
-                    edges.erase(itr);
-                    return;
-                }
-            }
+        void remove(uint32_t e) {
+            PROFILE_COUNT(SWEEP_STATUS_OPS);
+            if (!contains(e)) return;
+            edges.erase(handle[e]);
+            handle[e] = edges.end();
         }
 };
 
 /**
- * @brief try to fix and connect the Vertex v to the helper of Edge e 
+ * @brief try to fix and connect the Vertex v to the helper of Edge e
  * 
  * This method only connects v to helper(e) only if v is a merge vertex
  * 
- * @param v Vertex who needs to be connected to a helper
- * @param e The upper Edge whose helper us used to draw diagonal
+ * @param v position of the Vertex who needs to be connected to a helper
+ * @param e position of the upper Edge whose helper us used to draw diagonal
  * @param graph The current Graph object on which the operations are performed
  * @param status The current SweepStatus object which contains all the intersecting edges
  */
-void fixup(Vertex &v, Edge &e, Graph &graph, SweepStatus &status) {
-    Vertex helper = status.helper(e);
+void fixup(uint32_t v, uint32_t e, Graph &graph, SweepStatus &status) {
+    uint32_t helper = status.helper(e);
+    if (helper == noVertex) return;
     // if helper is a merge vertex, add diagonal from v to this vertex
-    Vertex hPrev = graph.prev(helper); // previous vertex of helper
-    Vertex hNext = graph.next(helper); // next vertex of helper
-    if (hPrev.x < helper.x && hNext.x < helper.x && orient(hPrev, helper, hNext) > 0) { // if merge vertex
+    const Vertex &h = graph.original[helper];
+    const Vertex &hPrev = graph.original[graph.prev(helper)]; // previous vertex of helper
+    const Vertex &hNext = graph.original[graph.next(helper)]; // next vertex of helper
+    if (hPrev < h && hNext < h && orient(hPrev, h, hNext) > 0) { // if merge vertex
         graph.connect(helper, v);
     }
 }
 
-void checkSort(vector<Vertex>& events, vector<Vertex>& original) {
-    for (unsigned long i=0; i<events.size()-1; i++) {
-        if (events[i].x == events[i+1].x) {
-            if (original[(events[i].tag+1)%original.size()] == events[i+1]) {
-                auto &test = original[(events[i].tag+2)%original.size()];
-                // if test.x > events[i].x, we are on upside of polygon and no changes required
-                // if test.x < events[i].x, we are on lower side, swap.
-                if (test.x < events[i].x) {
-                    swap(events[i], events[i+1]);
-                }
-            }
-            else if (original[(events[i].tag-1)%original.size()] == events[i+1]) {
-                auto &test = original[(events[i].tag+1)%original.size()];
-                if (test.x > events[i].x) {
-                    swap(events[i], events[i+1]);
-                }
-            }
-        }
-    }
-}
-
 /**
  * @brief Returns the monotones present in the input polygon
  * 
- * This is the main function which performs plane sweep algorithm to 
+ * This is the main function which performs plane sweep algorithm to
  * detect and return the monotones present in the polygon after adding
  * required diagonals
  * 
- * @param input Clockwise ordering of vertices of input polygon
- * @return list<vector<Vertex>> List of polygons which are monotone (vertices of each monotone are clockwise ordered)
+ * @param input Clockwise ordering of vertices of input polygon, which must outlive the sweep
+ * @return list<vector<uint32_t>> List of polygons which are monotone, as positions of their vertices in input (clockwise ordered)
  */
-list<vector<Vertex>> getMonotones(vector<Vertex> input) {
-    vector<vector<Vertex>> monotones;
+list<vector<uint32_t>> getMonotones(const vector<Vertex> &input) {
     Graph graph(input);
-    SweepStatus status;
-    vector<Vertex> events = graph.original;
-    // events are vertices of polygon stored in sorted order (by x-axis)
-    sort(events.begin(), events.end());
-    // check sort at same x coordinate points
-    checkSort(events, graph.original);
-    for (Vertex &v: events) { // for each event
-        Vertex u = graph.prev(v);
-        Vertex w = graph.next(v);
-        // orient < 0: inner angle and orient > 0: reflex angle
-        // 6 possible cases for each event
-        // cout << "Processing: " << u << " " << v << " " << w << "\n";
-        if (v.x < u.x && v.x < w.x && orient(u, v, w) < 0) { // Start Vertex
-            // both edges lie to the right of v, int.angle smaller than pi
-            status.insert(Edge(v, w), v);
-            // cout << "StV: " << v << "\n";
-            // cout << "ins: " << Edge(v, w) << "\n";
-        }
-        else if (u.x < v.x && w.x < v.x && orient(u, v, w) < 0) { // End Vertex
-            // both edges lie to the left of v, int.angle smaller than pi
-            Edge e = status.getUpper(v);
-            fixup(v, e, graph, status);
-            status.remove(Edge(u, v));
-        }
-        else if (v.x < u.x && v.x < w.x && orient(u, v, w) > 0) { // Split Vertex: looks like start vertex but angle is reflex
-            Edge e = status.getUpper(v);
-            graph.connect(v, status.helper(e));
-            status.insert(Edge(v, w), v);
-            // cout << "SplitV: " << v << "\n";
-            // cout << "conn: " << v << ", " << status.helper(e) << "\n";
-            // cout << "ins: " << Edge(v, w) << "\n";
-        }
-        else if (u.x < v.x && w.x < v.x && orient(u, v, w) > 0) { // Merge Vertex: looks like end vertex but angle is reflex
-            Edge eb = Edge(u, v);
-            status.remove(eb);
-            Edge e = status.getUpper(v);
-            fixup(v, e, graph, status);
-            fixup(v, eb, graph, status);
-            status.setHelper(e, v);
-            // cout << "MergeV: " << v << "\n";
-            // cout << "rm: " << Edge(u,v) << "\n";
-        }
-        else if (u.x <= v.x && v.x <= w.x) { // Upper Chain Vertex, same x coordinate degenarate case included
-            // one vertex to right and one to left with polygon interior below
-            Edge e = Edge(u, v);
-            fixup(v, e, graph, status);
-            // cout << "UC-fixup: " << e << ", h: " << status.helper(e) << ", " << v << "\n";
-            status.remove(e);
-            status.insert(Edge(v, w), v);
-            // cout << "rm: " << e << "\n";
-            // cout << "ins: " << Edge(v,w) << "\n";
-        }
-        else if (w.x <= v.x && v.x <= u.x) { // Lower Chain Vertex
-            // one vertex to right and one to left with polygon interior above
-            Edge e = status.getUpper(v);
-            fixup(v, e, graph, status);
-            // cout << "LC-fixup: " << e << ", h: " << status.helper(e) << ", " << v << "\n";
-        }
-        else { // when orient == 0 and u-v-w are collinear points parallel to y-axis
-            // this is a degenarate case.
-            // cout << "!!!!!DC!!!!!!\n";
-            if (w.y > v.y) { // part of upper edge
-                status.remove(Edge(u, v));
-                status.insert(Edge(v, w), v);
+    SweepStatus status(input);
+    vector<uint32_t> events(input.size());
+    // events are vertices of polygon stored in sorted (x, y) order, so a vertex above another
+    // one on the same vertical line comes after it, as if the plane were slightly sheared
+    // and no two vertices shared an x; every comparison below uses the same order
+    {
+        PROFILE_SCOPE("sort");
+        for (uint32_t i = 0; i < events.size(); i++) events[i] = i;
+        sort(events.begin(), events.end(), [&input](uint32_t a, uint32_t b) {
+            return input[a] < input[b] || (!(input[b] < input[a]) && a < b);
+        });
+    }
+    {
+        PROFILE_SCOPE("sweep");
+        for (uint32_t v: events) { // for each event
+            uint32_t u = graph.prev(v);
+            uint32_t w = graph.next(v);
+            const Vertex &pu = input[u], &pv = input[v], &pw = input[w];
+            // orient < 0: inner angle and orient > 0: reflex angle
+            // 6 possible cases for each event
+            if (pv < pu && pv < pw && orient(pu, pv, pw) < 0) { // Start Vertex
+                // both edges lie to the right of v, int.angle smaller than pi
+                status.insert(v, v);
+            }
+            else if (pu < pv && pw < pv && orient(pu, pv, pw) < 0) { // End Vertex
+                // both edges lie to the left of v, int.angle smaller than pi
+                uint32_t e = status.getUpper(v);
+                fixup(v, e, graph, status);
+                status.remove(u);
+            }
+            else if (pv < pu && pv < pw && orient(pu, pv, pw) > 0) { // Split Vertex: looks like start vertex but angle is reflex
+                uint32_t e = status.getUpper(v);
+                uint32_t helper = status.helper(e);
+                if (helper != noVertex) graph.connect(v, helper);
+                status.setHelper(e, v); // v is the latest vertex seen below e
+                status.insert(v, v);
+            }
+            else if (pu < pv && pw < pv && orient(pu, pv, pw) > 0) { // Merge Vertex: looks like end vertex but angle is reflex
+                uint32_t eb = u;
+                fixup(v, eb, graph, status); // before eb and its helper leave the status
+                status.remove(eb);
+                uint32_t e = status.getUpper(v);
+                fixup(v, e, graph, status);
+                status.setHelper(e, v);
+            }
+            else if (pu < pv && pv < pw) { // Upper Chain Vertex
+                // one vertex to right and one to left with polygon interior below
+                uint32_t e = u;
+                fixup(v, e, graph, status);
+                status.remove(e);
+                status.insert(v, v);
             }
-            else { // part of lower edge
-                status.remove(Edge(v, w));
-                status.insert(Edge(u, v), v);
+            else if (pw < pv && pv < pu) { // Lower Chain Vertex
+                // one vertex to right and one to left with polygon interior above
+                uint32_t e = status.getUpper(v);
+                fixup(v, e, graph, status);
+                status.setHelper(e, v); // v is the latest vertex seen below e
             }
         }
     }
+    PROFILE_SCOPE("subpolygons");
     return graph.getSubPolygons();
 }
 
@@ -3,111 +3,130 @@
  * @author Rikil Gajarla (f20170202@hyderabad.bits-pilani.ac.in)
  * @brief This file contains the method to triangulate a monotone polygon.
  * 
+ * A monotone is given as the positions of its vertices in the list of polygon vertices,
+ * and its chains are ranges of these positions, so no Vertex is copied before the
+ * triangles are built.
+ * 
  */
 
 #ifndef __MONOTONETRIANGULATION_H__
 #define __MONOTONETRIANGULATION_H__
 
-#include <list>
+#include <deque>
 #include <vector>
+#include <cstdint>
+#include <utility>
 #include <algorithm>
 #include "Geometry.h"
 #include "Tools.h"
 
 using namespace std;
 
+/**
+ * @class Chain
+ * @brief One of the two chains of a monotone polygon, from its leftmost to its rightmost vertex
+ * 
+ * The chain is a range of positions in the clockwise list of vertices of the monotone,
+ * walked forward for the top chain and backward for the bottom chain.
+ * 
+ */
+class Chain {
+    public:
+        const vector<uint32_t> *monotone; //< positions of the vertices of the monotone in clockwise order
+        unsigned long first; //< position in monotone of the first (leftmost) vertex of the chain
+        unsigned long length; //< number of vertices on the chain
+        bool forward; //< true if the chain follows the clockwise order of the monotone
+
+        /**
+         * @brief Number of vertices on the chain
+         * 
+         * @return unsigned long size of the chain
+         */
+        unsigned long size() const {
+            return length;
+        }
+
+        /**
+         * @brief The k-th vertex of the chain from the left
+         * 
+         * @param k index of the vertex on the chain
+         * @return uint32_t position of the vertex in the list of polygon vertices
+         */
+        uint32_t operator[](unsigned long k) const {
+            unsigned long m = monotone->size();
+            return (*monotone)[forward ? (first + k) % m : (first + m - k) % m];
+        }
+};
+
 /**
  * @brief Get the Top Chain of the monotone polygon
  * 
- * @param sorted Vertices of polygon sorted w.r.t x-axis
- * @param original unmodified clockwise ordering of vertices of polygon as given by the user
- * @return vector<Vertex> List of vertices present on the top chain of monotone
+ * @param monotone positions of the vertices of the monotone in clockwise order
+ * @param left position in monotone of its leftmost vertex
+ * @param right position in monotone of its rightmost vertex
+ * @return Chain vertices present on the top chain of monotone, from left to right
  */
-vector<Vertex> getTopChain(vector<Vertex>& sorted, vector<Vertex>& original) {
-    Vertex left = sorted[0];
-    Vertex right = sorted[sorted.size()-1];
-    vector<Vertex> chain;
-    // in the clockwise ordering of original, find where leftmost vertex is
-    unsigned long i = 0;
-    for (; i<original.size(); i++) {
-        if (original[i] == left) break;
-    }
-    while(original[i] != right) {
-        chain.push_back(original[i]);
-        i = (i+1) % original.size();
-    }
-    chain.push_back(right);
-    return chain;
+Chain getTopChain(const vector<uint32_t> &monotone, unsigned long left, unsigned long right) {
+    // in the clockwise ordering, the top chain goes from the leftmost to the rightmost vertex
+    unsigned long m = monotone.size();
+    return Chain{&monotone, left, (right + m - left) % m + 1, true};
 }
 
 /**
  * @brief Get the Bottom Chain of the monotone polygon
  * 
- * @param sorted Vertices of polygon sorted w.r.t x-axis
- * @param original unmodified clockwise ordering of vertices of polygon as given by the user
- * @return vector<Vertex> List of vertices present on the bottom chain of monotone
+ * @param monotone positions of the vertices of the monotone in clockwise order
+ * @param left position in monotone of its leftmost vertex
+ * @param right position in monotone of its rightmost vertex
+ * @return Chain vertices present on the bottom chain of monotone, from left to right
  */
-vector<Vertex> getBottomChain(vector<Vertex>& sorted, vector<Vertex>& original) {
-    Vertex left = sorted[0];
-    Vertex right = sorted[sorted.size()-1];
-    vector<Vertex> chain;
-    // in the clockwise ordering of original, find where leftmost vertex is
-    unsigned long i = 0;
-    for (; i<original.size(); i++) {
-        if (original[i] == right) break;
-    }
-    while(original[i] != left) {
-        chain.push_back(original[i]);
-        i = (i+1) % original.size();
-    }
-    chain.push_back(left);
-    return vector<Vertex>(chain.rbegin(), chain.rend());
+Chain getBottomChain(const vector<uint32_t> &monotone, unsigned long left, unsigned long right) {
+    // in the clockwise ordering, the bottom chain goes from the rightmost to the leftmost vertex
+    unsigned long m = monotone.size();
+    return Chain{&monotone, left, (left + m - right) % m + 1, false};
 }
 
 /**
  * @brief Assign top or bottom to each vertex and sort them w.r.t x-axis
  * 
- * @param input List of vertices representing the clockwise ordering of polygon vertices
- * @param left The left most Vertex present on the polygon
- * @param right The right most Vertex present on the polygon
- * @return vector<Vertex> x-axis soreted list of Vertices of the polygon
+ * @param points List of vertices representing the clockwise ordering of polygon vertices
+ * @param monotone positions of the vertices of the monotone in clockwise order
+ * @param left position in monotone of its leftmost vertex
+ * @param right position in monotone of its rightmost vertex
+ * @return vector<pair<uint32_t, bool>> x-axis soreted positions of the vertices of the monotone, with their side (true for bottom)
  */
-vector<Vertex> preprocess(vector<Vertex> input, Vertex &left, Vertex &right) {
-    // in the clockwise ordering of original, find where leftmost vertex is
-    unsigned long i = 0;
-    for (; i < input.size(); i++) {
-        if (input[i] == left)
-            break;
-    }
-    while (input[i] != right) {
-        input[i].tag = 0; // topside
-        i = (i + 1) % input.size();
+vector<pair<uint32_t, bool>> preprocess(const vector<Vertex> &points, const vector<uint32_t> &monotone, unsigned long left, unsigned long right) {
+    vector<pair<uint32_t, bool>> sorted;
+    sorted.reserve(monotone.size());
+    Chain top = getTopChain(monotone, left, right), bottom = getBottomChain(monotone, left, right);
+    for (unsigned long k = 0; k < top.size(); k++) {
+        sorted.emplace_back(top[k], false); // topside, both left and right are in topside
     }
-    input[i].tag = 0; // both left and right are in topside
-    i = (i + 1) % input.size();
-    while (input[i] != left) {
-        input[i].tag = 1; // bottomside
-        i = (i + 1) % input.size();
+    for (unsigned long k = 1; k + 1 < bottom.size(); k++) {
+        sorted.emplace_back(bottom[k], true); // bottomside
     }
     // sort wrt x axis
-    sort(input.begin(), input.end());
-    return input;
+    sort(sorted.begin(), sorted.end(), [&points](const pair<uint32_t, bool> &a, const pair<uint32_t, bool> &b) {
+        const Vertex &p = points[a.first], &q = points[b.first];
+        return p < q || (!(q < p) && a.first < b.first);
+    });
+    return sorted;
 }
 
 /**
  * @brief Check if the triangle formed by the vertices is valid
  * 
- * A triangle is said to be valid only if it completely exists inside the 
+ * A triangle is said to be valid only if it completely exists inside the
  * polygon
  * 
  * @param a First Vertex
  * @param b Second Vertex
  * @param c Third Vertex
- * @param midSide Side of the middle vertex (top or bottom as set in the tag of Vertex)
+ * @param midSide Side of the middle vertex (top or bottom as set by preprocess())
  * @return true If the triangle formed is valid
  * @return false otherwise
  */
-bool validTriangle(Vertex &a, Vertex &b, Vertex &c, bool midSide) {
+bool validTriangle(const Vertex &a, const Vertex &b, const Vertex &c, bool midSide) {
     Vertex ab = b-a;
     Vertex bc = c-b;
     if (midSide) { // bottomside
@@ -121,39 +140,47 @@ bool validTriangle(Vertex &a, Vertex &b, Vertex &c, bool midSide) {
 /**
  * @brief Get the minimum Vertex (based on the x-axis)
  * 
- * @param input List of vertices of polygon
- * @return Vertex The minimum vertex
+ * @param points List of vertices of polygon
+ * @param monotone positions of the vertices of the monotone
+ * @return unsigned long position in monotone of the minimum vertex
  */
-Vertex findMin(const vector<Vertex> &input) {
-    Vertex mn = input[0];
-    for (const Vertex &v: input) mn = min(mn, v);
+unsigned long findMin(const vector<Vertex> &points, const vector<uint32_t> &monotone) {
+    unsigned long mn = 0;
+    for (unsigned long i = 1; i < monotone.size(); i++) {
+        if (points[monotone[i]] < points[monotone[mn]]) mn = i;
+    }
     return mn;
 }
 
 /**
  * @brief Get the maximum Vertex (based on the x-axis)
  * 
- * @param input List of vertices of polygon
- * @return Vertex The maximum vertex
+ * @param points List of vertices of polygon
+ * @param monotone positions of the vertices of the monotone
+ * @return unsigned long position in monotone of the maximum vertex
  */
-Vertex findMax(const vector<Vertex> &input) {
-    Vertex mx = input[0];
-    for (const Vertex &v: input) mx = max(mx, v);
+unsigned long findMax(const vector<Vertex> &points, const vector<uint32_t> &monotone) {
+    unsigned long mx = 0;
+    for (unsigned long i = 1; i < monotone.size(); i++) {
+        if (points[monotone[mx]] < points[monotone[i]]) mx = i;
+    }
     return mx;
 }
 
 /**
  * @brief This method performs the triangulation of the given monotone
  * 
- * @param input List of vertices present on the monotone in clockwise order
+ * @param points List of vertices of the polygon in clockwise order
+ * @param monotone positions in points of the vertices of the monotone in clockwise order
  * @return vector<Triangle> List of Triangle objects produced after triangulating the monotone
  */
-vector<Triangle> monotoneTriangulate(vector<Vertex> input) {
+vector<Triangle> monotoneTriangulate(const vector<Vertex> &points, const vector<uint32_t> &monotone) {
     vector<Triangle> output;
-    Vertex left = findMin(input), right = findMax(input);
+    if (monotone.size() < 3) return output;
+    unsigned long left = findMin(points, monotone), right = findMax(points, monotone);
     // assign chain sides and sort input w.r.t x axis
-    input = preprocess(input, left, right);
-    list<Vertex> stk; // queue/stack chain (also the reflex chain)
+    vector<pair<uint32_t, bool>> input = preprocess(points, monotone, left, right);
+    deque<pair<uint32_t, bool>> stk; // queue/stack chain (also the reflex chain)
     unsigned long i=0;
     while(i != input.size()) {
         if (stk.size() < 2) {
@@ -161,16 +188,16 @@ vector<Triangle> monotoneTriangulate(vector<Vertex> input) {
             i++;
             continue;
         }
-        Vertex p, u; // p = vertex eliminated if triangulated, u = adjoining to p
-        Vertex v = input[i]; // new vertex
-        bool vSide = v.tag;
-        if (vSide == stk.back().tag) { // same side
+        pair<uint32_t, bool> p, u; // p = vertex eliminated if triangulated, u = adjoining to p
+        pair<uint32_t, bool> v = input[i]; // new vertex
+        bool vSide = v.second;
+        if (vSide == stk.back().second) { // same side
             while (stk.size() >= 2) {
                 p = stk.back();
                 stk.pop_back();
                 u = stk.back();
-                if (validTriangle(u, p, v, p.tag)) {
-                    output.emplace_back(u, p, v);
+                if (validTriangle(points[u.first], points[p.first], points[v.first], p.second)) {
+                    output.emplace_back(points[u.first], points[p.first], points[v.first]);
                 } else {
                     stk.push_back(p); // push the popped vertex to chain
                     break;            // since we can't form proper triangles
@@ -181,7 +208,7 @@ vector<Triangle> monotoneTriangulate(vector<Vertex> input) {
                 p = stk.front();
                 stk.pop_front();
                 u = stk.front();
-                output.emplace_back(v, p, u);
+                output.emplace_back(points[v.first], points[p.first], points[u.first]);
             }
         }
         stk.push_back(v); // add current vertex to stack
@@ -10,9 +10,11 @@
 
 #include <list>
 #include <vector>
+#include <cstdint>
 #include "Geometry.h"
 #include "monotoneSubdivision.h"
 #include "monotoneTriangulation.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -25,9 +27,9 @@ using namespace std;
  * @param input List of Vertices of Polygons present in clockwise order
  * @return vector<Triangle> List of Triangle objects representing the triangulation of polygon
  */
-vector<Triangle> planeSweepTriangulate(vector<Vertex> input) {
+vector<Triangle> planeSweepTriangulate(const vector<Vertex> &input) {
     vector<Triangle> output;
-    list<vector<Vertex>> monotones = getMonotones(input);
+    list<vector<uint32_t>> monotones = getMonotones(input);
     // cout << "no of monotones: " << monotones.size() << "\n";
     // for (auto &monotone: monotones) {
     //     for (auto &x: monotone) {
@@ -35,8 +37,9 @@ vector<Triangle> planeSweepTriangulate(vector<Vertex> input) {
     //     }cout << "\n";
     // }
     // exit(1);
+    PROFILE_SCOPE("triangulate");
     for (auto &monotone: monotones) {
-        vector<Triangle> temp = monotoneTriangulate(monotone);
+        vector<Triangle> temp = monotoneTriangulate(input, monotone);
         output.insert(output.end(), temp.begin(), temp.end());
     }
     return output;